@@ -0,0 +1,57 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <stdio.h>
+#include <stddef.h>
+#include <chrono>
+
+// Timing for the benchmark executables: best of a few runs, in nanoseconds per iteration.
+// job(iteration) is called iterationCount times per run.
+template<typename Job> double MeasureNanoseconds(size_t iterationCount, Job&& job)
+{
+    double best = 0.;
+    for (int run = 0; run < 5; run++)
+    {
+        const auto start = std::chrono::high_resolution_clock::now();
+        for (size_t i = 0; i < iterationCount; i++)
+        {
+            job(i);
+        }
+        const auto end = std::chrono::high_resolution_clock::now();
+        const double duration = std::chrono::duration<double, std::nano>(end - start).count() / double(iterationCount);
+        best = (run && best < duration) ? best : duration;
+    }
+    return best;
+}
+
+static inline void PrintMeasure(const char* name, double nanoseconds)
+{
+    printf("%-40s %10.2f ns\n", name, nanoseconds);
+}
+
+// keeps results alive so the measured code isn't optimized away
+static volatile float gBenchSink;
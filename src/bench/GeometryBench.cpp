@@ -0,0 +1,124 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Matrix and vector operations of GeometryTypes.h. Built twice, the scalar build defines
+// GEMONI_NO_SIMD: compare GeometryBench and GeometryBenchScalar outputs.
+
+#include <vector>
+#include "GeometryTypes.h"
+#include "GeometryBatch.h"
+#include "BenchUtils.h"
+
+static const size_t MatrixCount = 1024;
+static const size_t PointCount = 100000;
+
+int main(int, char**)
+{
+#if defined(GEMONI_SSE)
+    printf("GeometryTypes SSE path\n");
+#elif defined(GEMONI_NEON)
+    printf("GeometryTypes NEON path\n");
+#else
+    printf("GeometryTypes scalar path\n");
+#endif
+
+    std::vector<Mat4x4> matrices(MatrixCount);
+    for (size_t i = 0; i < MatrixCount; i++)
+    {
+        matrices[i].RotationAxis(Vec4(1.f, float(i % 7), 3.f), float(i) * 0.01f);
+        matrices[i].m[3][0] = float(i);
+    }
+    std::vector<Vec4> points(PointCount);
+    for (size_t i = 0; i < PointCount; i++)
+    {
+        points[i] = Vec4(float(i % 101), float(i % 37) - 10.f, float(i % 13), 1.f);
+    }
+
+    Mat4x4 product;
+    product.Identity();
+    PrintMeasure("Mat4x4::Multiply", MeasureNanoseconds(1000000, [&](size_t i) {
+        product.Multiply(matrices[i % MatrixCount], matrices[(i + 1) % MatrixCount]);
+        gBenchSink = product.m16[i & 15];
+    }));
+
+    // matrices are rigid, InverseAuto takes the affine path
+    Mat4x4 inverse;
+    PrintMeasure("Mat4x4::Inverse", MeasureNanoseconds(1000000, [&](size_t i) {
+        inverse.Inverse(matrices[i % MatrixCount]);
+        gBenchSink = inverse.m16[i & 15];
+    }));
+    PrintMeasure("Mat4x4::Inverse (affine)", MeasureNanoseconds(1000000, [&](size_t i) {
+        inverse.Inverse(matrices[i % MatrixCount], true);
+        gBenchSink = inverse.m16[i & 15];
+    }));
+    PrintMeasure("Mat4x4::InverseAuto", MeasureNanoseconds(1000000, [&](size_t i) {
+        inverse.InverseAuto(matrices[i % MatrixCount]);
+        gBenchSink = inverse.m16[i & 15];
+    }));
+    PrintMeasure("Mat4x4::InverseRigid", MeasureNanoseconds(1000000, [&](size_t i) {
+        inverse.InverseRigid(matrices[i % MatrixCount]);
+        gBenchSink = inverse.m16[i & 15];
+    }));
+    PrintMeasure("Mat4x4::IsRigid", MeasureNanoseconds(1000000, [&](size_t i) {
+        gBenchSink = matrices[i % MatrixCount].IsRigid() ? 1.f : 0.f;
+    }));
+    std::vector<Mat4x4> inverses(MatrixCount);
+    PrintMeasure("InverseBatch (per matrix)", MeasureNanoseconds(100, [&](size_t i) {
+        InverseBatch(matrices.data(), inverses.data(), MatrixCount);
+        gBenchSink = inverses[i % MatrixCount].m16[i & 15];
+    }) / double(MatrixCount));
+
+    Mat4x4 transposed = matrices[0];
+    PrintMeasure("Mat4x4::transpose", MeasureNanoseconds(1000000, [&](size_t i) {
+        transposed.transpose();
+        gBenchSink = transposed.m16[i & 15];
+    }));
+
+    const Mat4x4& matrix = matrices[1];
+    PrintMeasure("Vec4::TransformPoint", MeasureNanoseconds(PointCount, [&](size_t i) {
+        Vec4 point = points[i];
+        point.TransformPoint(matrix);
+        gBenchSink = point.x + point.y + point.z + point.w;
+    }));
+    PrintMeasure("Vec4::TransformVector", MeasureNanoseconds(PointCount, [&](size_t i) {
+        Vec4 vector = points[i];
+        vector.TransformVector(matrix);
+        gBenchSink = vector.x + vector.y + vector.z + vector.w;
+    }));
+
+    // per point, the whole array at once
+    std::vector<Vec3> packedPoints(PointCount);
+    std::vector<Vec3> transformedPoints(PointCount);
+    for (size_t i = 0; i < PointCount; i++)
+    {
+        packedPoints[i] = { points[i].x, points[i].y, points[i].z };
+    }
+    PrintMeasure("TransformPoints (per point)", MeasureNanoseconds(10, [&](size_t) {
+        Bounds bounds;
+        TransformPoints(matrix, packedPoints.data(), transformedPoints.data(), PointCount, &bounds);
+        gBenchSink = bounds.mMax.x;
+    }) / double(PointCount));
+    return 0;
+}
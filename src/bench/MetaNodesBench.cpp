@@ -0,0 +1,92 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// GetParameterOffset and ComputeNodeParametersSize with the layout table computed when the
+// node is read, against summing the parameter type sizes on each call as they used to.
+
+#include <string>
+#include <vector>
+#include "MetaNodes.h"
+#include "BenchUtils.h"
+
+static const size_t ParameterCount = 32;
+
+static size_t SummedParameterOffset(uint32_t nodeType, uint32_t parameterIndex)
+{
+    size_t offset = 0;
+    uint32_t i = 0;
+    for (const MetaParameter& param : gMetaNodes[nodeType].mParams)
+    {
+        if (i == parameterIndex)
+        {
+            break;
+        }
+        offset += GetParameterTypeSize(param.mType);
+        i++;
+    }
+    return offset;
+}
+
+static size_t SummedParametersSize(uint32_t nodeType)
+{
+    size_t size = 0;
+    for (const MetaParameter& param : gMetaNodes[nodeType].mParams)
+    {
+        size += GetParameterTypeSize(param.mType);
+    }
+    return size;
+}
+
+int main(int, char**)
+{
+    static const ConTypes types[] = { Con_Float, Con_Float4, Con_Int, Con_Color4, Con_Enum, Con_Float2, Con_Bool };
+    MetaNode node{};
+    node.mName = "Bench";
+    for (size_t i = 0; i < ParameterCount; i++)
+    {
+        MetaParameter param;
+        param.mName = "param" + std::to_string(i);
+        param.mType = types[i % (sizeof(types) / sizeof(types[0]))];
+        node.mParams.push_back(param);
+    }
+    ComputeMetaNodeLayout(node);
+    gMetaNodes.push_back(node);
+    const uint32_t nodeType = uint32_t(gMetaNodes.size() - 1);
+
+    printf("%d parameters, offsets of every parameter\n", int(ParameterCount));
+    PrintMeasure("GetParameterOffset (layout table)", MeasureNanoseconds(1000000, [&](size_t i) {
+        gBenchSink = float(GetParameterOffset(nodeType, uint32_t(i % ParameterCount)));
+    }));
+    PrintMeasure("GetParameterOffset (summed)", MeasureNanoseconds(1000000, [&](size_t i) {
+        gBenchSink = float(SummedParameterOffset(nodeType, uint32_t(i % ParameterCount)));
+    }));
+    PrintMeasure("ComputeNodeParametersSize (layout table)", MeasureNanoseconds(1000000, [&](size_t) {
+        gBenchSink = float(ComputeNodeParametersSize(nodeType));
+    }));
+    PrintMeasure("ComputeNodeParametersSize (summed)", MeasureNanoseconds(1000000, [&](size_t) {
+        gBenchSink = float(SummedParametersSize(nodeType));
+    }));
+    return 0;
+}
@@ -0,0 +1,112 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Node selection of a 10k nodes graph: NodeSelection against the std::set searched with
+// std::find the editor used before.
+
+#include <algorithm>
+#include <set>
+#include <vector>
+#include "NodeSelection.h"
+#include "BenchUtils.h"
+
+static const uint32_t NodeCount = 10000;
+
+struct SetSelection
+{
+    bool IsSelected(uint32_t nodeIndex) const
+    {
+        return std::find(mNodes.begin(), mNodes.end(), nodeIndex) != mNodes.end();
+    }
+    void Select(uint32_t nodeIndex, bool selected)
+    {
+        auto iter = std::find(mNodes.begin(), mNodes.end(), nodeIndex);
+        if (iter != mNodes.end())
+        {
+            if (!selected)
+            {
+                mNodes.erase(iter);
+            }
+        }
+        else if (selected)
+        {
+            mNodes.insert(nodeIndex);
+        }
+    }
+    void Clear()
+    {
+        mNodes.clear();
+    }
+    std::vector<uint32_t> GetNodes() const
+    {
+        return std::vector<uint32_t>(mNodes.begin(), mNodes.end());
+    }
+
+    std::set<uint32_t> mNodes;
+};
+
+// select everything, 10 frames of per node tests, click on a node (unselect all), select half
+template<typename Selection> static size_t RunEditorSequence(Selection& selection)
+{
+    for (uint32_t i = 0; i < NodeCount; i++)
+    {
+        selection.Select(i, true);
+    }
+    size_t selectedCount = 0;
+    for (int frame = 0; frame < 10; frame++)
+    {
+        for (uint32_t i = 0; i < NodeCount; i++)
+        {
+            selectedCount += selection.IsSelected(i) ? 1 : 0;
+        }
+    }
+    for (uint32_t i = 0; i < NodeCount; i++)
+    {
+        selection.Select(i, false);
+    }
+    for (uint32_t i = 0; i < NodeCount; i += 2)
+    {
+        selection.Select(i, true);
+    }
+    selectedCount += selection.GetNodes().size();
+    selection.Clear();
+    return selectedCount;
+}
+
+int main(int, char**)
+{
+    printf("%d nodes\n", int(NodeCount));
+    const double bitsetTime = MeasureNanoseconds(10, [](size_t) {
+        NodeSelection selection;
+        gBenchSink = float(RunEditorSequence(selection));
+    });
+    PrintMeasure("NodeSelection", bitsetTime);
+    const double setTime = MeasureNanoseconds(1, [](size_t) {
+        SetSelection selection;
+        gBenchSink = float(RunEditorSequence(selection));
+    });
+    PrintMeasure("std::set with std::find", setTime);
+    return 0;
+}
@@ -25,6 +25,8 @@
 
 #include "Camera.h"
 #include "Utils.h"
+#include <algorithm>
+#include <string.h>
 
 Camera Camera::Lerp(const Camera& target, float t)
 {
@@ -59,7 +61,7 @@ float& Camera::operator[](int index)
     case 5:
         return mDirection[index - 3];
     case 6:
-        return mDirection[index - 6];
+        return mLens.x;
     }
     return mPosition[0];
 }
@@ -71,10 +73,16 @@ void Camera::ComputeViewProjectionMatrix(float* viewProj, float* viewInverse) co
     Mat4x4& vp = *(Mat4x4*)viewProj;
     ComputeViewMatrix(view.m16, vi.m16);
 
-    proj.glhPerspectivef2(53.f, 1.f, 0.01f, 100.f);
+    ComputeProjectionMatrix(proj.m16);
     vp = view * proj;
 }
 
+void Camera::ComputeProjectionMatrix(float* proj, float aspectRatio) const
+{
+    Mat4x4& p = *(Mat4x4*)proj;
+    p.glhPerspectivef2(GetFov(), aspectRatio, GetNear(), GetFar());
+}
+
 void Camera::ComputeViewMatrix(float* view, float* viewInverse) const
 {
     Mat4x4& v = *(Mat4x4*)view;
@@ -90,4 +98,89 @@ void Camera::SetViewMatrix(float* view)
     mPosition.TransformPoint(Vec4(0.f, 0.f, 0.f), matrix);
     mDirection.TransformVector(Vec4(0.f, 0.f, -1.f), matrix);
     mUp.TransformVector(Vec4(0.f, 1.f, 0.f), matrix);
-}
\ No newline at end of file
+}
+
+bool CameraMatrices::Update(const Camera& camera, float aspectRatio)
+{
+    if (!mbDirty && aspectRatio == mAspectRatio && !memcmp(&camera, &mCamera, sizeof(Camera)))
+    {
+        return false;
+    }
+    mCamera = camera;
+    mAspectRatio = aspectRatio;
+    mbDirty = false;
+    camera.ComputeViewMatrix(mView.m16, mViewInverse.m16);
+    camera.ComputeProjectionMatrix(mProjection.m16, aspectRatio);
+    mViewProjection.Multiply(mView, mProjection);
+    return true;
+}
+
+void SampleCameraTrack(const CameraKey* keys,
+                       size_t keyCount,
+                       const float* times,
+                       size_t count,
+                       float aspectRatio,
+                       Mat4x4* views,
+                       Mat4x4* viewInverses,
+                       Mat4x4* viewProjections)
+{
+    if (!keyCount)
+    {
+        return;
+    }
+    ParallelFor(count, 256, [&](size_t begin, size_t end) {
+        // key is the first key after the previous time. Times are usually increasing: the cursor
+        // moves forward, a binary search is done for the first time and when time goes backwards.
+        auto findKey = [keys, keyCount](float time) {
+            return size_t(std::upper_bound(keys, keys + keyCount, time, [](float t, const CameraKey& k) { return t < k.mTime; }) - keys);
+        };
+        size_t key = findKey(times[begin]);
+        for (size_t i = begin; i < end; i++)
+        {
+            const float time = times[i];
+            if (key > 0 && keys[key - 1].mTime > time)
+            {
+                key = findKey(time);
+            }
+            while (key < keyCount && keys[key].mTime <= time)
+            {
+                key++;
+            }
+            // keys[key - 1].mTime <= time < keys[key].mTime
+            Camera camera;
+            if (key == 0)
+            {
+                camera = keys[0].mCamera;
+            }
+            else if (key == keyCount)
+            {
+                camera = keys[keyCount - 1].mCamera;
+            }
+            else
+            {
+                const CameraKey& previous = keys[key - 1];
+                const CameraKey& next = keys[key];
+                const float duration = next.mTime - previous.mTime;
+                const float t = (duration > FLT_EPSILON) ? (time - previous.mTime) / duration : 0.f;
+                camera = Camera(previous.mCamera).Lerp(next.mCamera, t);
+            }
+
+            Mat4x4 view, viewInverse;
+            camera.ComputeViewMatrix(view.m16, viewInverse.m16);
+            if (views)
+            {
+                views[i] = view;
+            }
+            if (viewInverses)
+            {
+                viewInverses[i] = viewInverse;
+            }
+            if (viewProjections)
+            {
+                Mat4x4 projection;
+                camera.ComputeProjectionMatrix(projection.m16, aspectRatio);
+                viewProjections[i].Multiply(view, projection);
+            }
+        }
+    });
+}
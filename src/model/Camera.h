@@ -32,7 +32,7 @@ struct Camera
     Vec4 mPosition;
     Vec4 mDirection;
     Vec4 mUp;
-    Vec4 mLens; // fov, distanceToTarget ....
+    Vec4 mLens; // fov in degrees, distanceToTarget, near, far. 0 for the default fov, near or far, far also defaults when not past near
 
     Camera Lerp(const Camera& target, float t);
     void LookAt(const Vec4& eye, const Vec4& target, const Vec4& up);
@@ -40,7 +40,61 @@ struct Camera
     void SetViewMatrix(float* view);
     void ComputeViewProjectionMatrix(float* viewProj, float* viewInverse) const;
     void ComputeViewMatrix(float* view, float* viewInverse) const;
+    void ComputeProjectionMatrix(float* proj, float aspectRatio = 1.f) const;
+
+    float GetFov() const
+    {
+        return (mLens.x > 0.f) ? mLens.x : 53.f;
+    }
+    float GetNear() const
+    {
+        return (mLens.z > 0.f) ? mLens.z : 0.01f;
+    }
+    float GetFar() const
+    {
+        const float cameraNear = GetNear();
+        return (mLens.w > cameraNear) ? mLens.w : Max(100.f, cameraNear * 2.f);
+    }
+};
+
+// Camera matrices rebuilt only when the camera or the aspect ratio change. Kept apart from Camera
+// that is stored as is in parameter blocks.
+struct CameraMatrices
+{
+    // returns true when the matrices were rebuilt
+    bool Update(const Camera& camera, float aspectRatio = 1.f);
+    void Invalidate()
+    {
+        mbDirty = true;
+    }
+
+    Mat4x4 mView;
+    Mat4x4 mViewInverse;
+    Mat4x4 mProjection;
+    Mat4x4 mViewProjection;
+
+private:
+    Camera mCamera;
+    float mAspectRatio{ 0.f };
+    bool mbDirty{ true };
 };
+
+struct CameraKey
+{
+    float mTime;
+    Camera mCamera;
+};
+
+// Samples a camera track, keys sorted by time, at every time. Times outside the track are clamped.
+// Output arrays have count entries, any of them may be null.
+void SampleCameraTrack(const CameraKey* keys,
+                       size_t keyCount,
+                       const float* times,
+                       size_t count,
+                       float aspectRatio,
+                       Mat4x4* views,
+                       Mat4x4* viewInverses,
+                       Mat4x4* viewProjections);
 /*
 inline Camera Lerp(Camera a, Camera b, float t)
 {
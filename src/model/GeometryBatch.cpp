@@ -0,0 +1,327 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <mutex>
+#include "GeometryBatch.h"
+
+#if defined(GEMONI_SSE) && defined(__AVX__)
+#include <immintrin.h>
+#endif
+
+// Widest vector available at compile time, 8 lanes with AVX, 4 with SSE or NEON, 1 otherwise.
+namespace
+{
+#if defined(GEMONI_SSE) && defined(__AVX__)
+    typedef __m256 Lanes;
+    const size_t LaneCount = 8;
+    inline Lanes Load(const float* ptr) { return _mm256_loadu_ps(ptr); }
+    inline void Store(float* ptr, Lanes v) { _mm256_storeu_ps(ptr, v); }
+    inline Lanes Splat(float v) { return _mm256_set1_ps(v); }
+    inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return _mm256_add_ps(_mm256_mul_ps(a, b), c); }
+    inline Lanes Mul(Lanes a, Lanes b) { return _mm256_mul_ps(a, b); }
+    inline Lanes LanesMin(Lanes a, Lanes b) { return _mm256_min_ps(a, b); }
+    inline Lanes LanesMax(Lanes a, Lanes b) { return _mm256_max_ps(a, b); }
+#elif defined(GEMONI_SSE)
+    typedef __m128 Lanes;
+    const size_t LaneCount = 4;
+    inline Lanes Load(const float* ptr) { return _mm_loadu_ps(ptr); }
+    inline void Store(float* ptr, Lanes v) { _mm_storeu_ps(ptr, v); }
+    inline Lanes Splat(float v) { return _mm_set1_ps(v); }
+    inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return _mm_add_ps(_mm_mul_ps(a, b), c); }
+    inline Lanes Mul(Lanes a, Lanes b) { return _mm_mul_ps(a, b); }
+    inline Lanes LanesMin(Lanes a, Lanes b) { return _mm_min_ps(a, b); }
+    inline Lanes LanesMax(Lanes a, Lanes b) { return _mm_max_ps(a, b); }
+#elif defined(GEMONI_NEON)
+    typedef float32x4_t Lanes;
+    const size_t LaneCount = 4;
+    inline Lanes Load(const float* ptr) { return vld1q_f32(ptr); }
+    inline void Store(float* ptr, Lanes v) { vst1q_f32(ptr, v); }
+    inline Lanes Splat(float v) { return vdupq_n_f32(v); }
+    inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return vmlaq_f32(c, a, b); }
+    inline Lanes Mul(Lanes a, Lanes b) { return vmulq_f32(a, b); }
+    inline Lanes LanesMin(Lanes a, Lanes b) { return vminq_f32(a, b); }
+    inline Lanes LanesMax(Lanes a, Lanes b) { return vmaxq_f32(a, b); }
+#else
+    typedef float Lanes;
+    const size_t LaneCount = 1;
+    inline Lanes Load(const float* ptr) { return *ptr; }
+    inline void Store(float* ptr, Lanes v) { *ptr = v; }
+    inline Lanes Splat(float v) { return v; }
+    inline Lanes MulAdd(Lanes a, Lanes b, Lanes c) { return a * b + c; }
+    inline Lanes Mul(Lanes a, Lanes b) { return a * b; }
+    inline Lanes LanesMin(Lanes a, Lanes b) { return Min(a, b); }
+    inline Lanes LanesMax(Lanes a, Lanes b) { return Max(a, b); }
+#endif
+
+    // arrays below this size are transformed on the calling thread
+    const size_t ParallelGrainSize = 16384;
+    // inverses per worker chunk
+    const size_t InverseGrainSize = 1024;
+    // packed points are transposed to SoA through stack blocks of this size
+    const size_t PackedBlockSize = 256;
+
+    static_assert(sizeof(Vec3) == 3 * sizeof(float), "packed Vec3 arrays are read as floats");
+
+    // bounds of per lane min and max
+    Bounds ReduceLanes(Lanes minX, Lanes minY, Lanes minZ, Lanes maxX, Lanes maxY, Lanes maxZ)
+    {
+        float lanes[6][LaneCount];
+        Store(lanes[0], minX);
+        Store(lanes[1], minY);
+        Store(lanes[2], minZ);
+        Store(lanes[3], maxX);
+        Store(lanes[4], maxY);
+        Store(lanes[5], maxZ);
+        Bounds bounds;
+        for (size_t lane = 0; lane < LaneCount; lane++)
+        {
+            Bounds laneBounds;
+            laneBounds.mMin = { lanes[0][lane], lanes[1][lane], lanes[2][lane] };
+            laneBounds.mMax = { lanes[3][lane], lanes[4][lane], lanes[5][lane] };
+            bounds.AddBounds(laneBounds);
+        }
+        return bounds;
+    }
+
+    // [begin, end) of SoA arrays, isPoint adds the translation
+    template<bool isPoint>
+    void TransformRange(const Mat4x4& matrix,
+                        const float* x, const float* y, const float* z,
+                        float* outX, float* outY, float* outZ,
+                        size_t begin, size_t end,
+                        Bounds* bounds)
+    {
+        const Lanes m00 = Splat(matrix.m[0][0]), m01 = Splat(matrix.m[0][1]), m02 = Splat(matrix.m[0][2]);
+        const Lanes m10 = Splat(matrix.m[1][0]), m11 = Splat(matrix.m[1][1]), m12 = Splat(matrix.m[1][2]);
+        const Lanes m20 = Splat(matrix.m[2][0]), m21 = Splat(matrix.m[2][1]), m22 = Splat(matrix.m[2][2]);
+        const Lanes t0 = Splat(isPoint ? matrix.m[3][0] : 0.f);
+        const Lanes t1 = Splat(isPoint ? matrix.m[3][1] : 0.f);
+        const Lanes t2 = Splat(isPoint ? matrix.m[3][2] : 0.f);
+        Lanes minX = Splat(FLT_MAX), minY = Splat(FLT_MAX), minZ = Splat(FLT_MAX);
+        Lanes maxX = Splat(-FLT_MAX), maxY = Splat(-FLT_MAX), maxZ = Splat(-FLT_MAX);
+
+        size_t i = begin;
+        for (; i + LaneCount <= end; i += LaneCount)
+        {
+            const Lanes px = Load(x + i), py = Load(y + i), pz = Load(z + i);
+            const Lanes rx = MulAdd(px, m00, MulAdd(py, m10, MulAdd(pz, m20, t0)));
+            const Lanes ry = MulAdd(px, m01, MulAdd(py, m11, MulAdd(pz, m21, t1)));
+            const Lanes rz = MulAdd(px, m02, MulAdd(py, m12, MulAdd(pz, m22, t2)));
+            Store(outX + i, rx);
+            Store(outY + i, ry);
+            Store(outZ + i, rz);
+            if (bounds)
+            {
+                minX = LanesMin(minX, rx);
+                minY = LanesMin(minY, ry);
+                minZ = LanesMin(minZ, rz);
+                maxX = LanesMax(maxX, rx);
+                maxY = LanesMax(maxY, ry);
+                maxZ = LanesMax(maxZ, rz);
+            }
+        }
+        // remaining points, scalar
+        Bounds local;
+        for (; i < end; i++)
+        {
+            const float px = x[i], py = y[i], pz = z[i];
+            outX[i] = px * matrix.m[0][0] + py * matrix.m[1][0] + pz * matrix.m[2][0] + (isPoint ? matrix.m[3][0] : 0.f);
+            outY[i] = px * matrix.m[0][1] + py * matrix.m[1][1] + pz * matrix.m[2][1] + (isPoint ? matrix.m[3][1] : 0.f);
+            outZ[i] = px * matrix.m[0][2] + py * matrix.m[1][2] + pz * matrix.m[2][2] + (isPoint ? matrix.m[3][2] : 0.f);
+            if (bounds)
+            {
+                local.AddPoint({ outX[i], outY[i], outZ[i] });
+            }
+        }
+        if (bounds)
+        {
+            local.AddBounds(ReduceLanes(minX, minY, minZ, maxX, maxY, maxZ));
+            bounds->AddBounds(local);
+        }
+    }
+
+    template<bool isPoint>
+    void TransformPackedRange(const Mat4x4& matrix, const Vec3* points, Vec3* outPoints, size_t begin, size_t end, Bounds* bounds)
+    {
+        float x[PackedBlockSize], y[PackedBlockSize], z[PackedBlockSize];
+        for (size_t blockBegin = begin; blockBegin < end; blockBegin += PackedBlockSize)
+        {
+            const size_t blockCount = Min(end - blockBegin, PackedBlockSize);
+            const Vec3* src = points + blockBegin;
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                x[i] = src[i].x;
+                y[i] = src[i].y;
+                z[i] = src[i].z;
+            }
+            TransformRange<isPoint>(matrix, x, y, z, x, y, z, 0, blockCount, bounds);
+            Vec3* dst = outPoints + blockBegin;
+            for (size_t i = 0; i < blockCount; i++)
+            {
+                dst[i] = { x[i], y[i], z[i] };
+            }
+        }
+    }
+
+    // packed Vec3 min/max: LaneCount points are 3 vectors, float k of a group being component k % 3
+    void AddPackedRange(Bounds& bounds, const Vec3* points, size_t begin, size_t end)
+    {
+        const float* data = &points[begin].x;
+        const size_t count = end - begin;
+        Lanes minValues[3] = { Splat(FLT_MAX), Splat(FLT_MAX), Splat(FLT_MAX) };
+        Lanes maxValues[3] = { Splat(-FLT_MAX), Splat(-FLT_MAX), Splat(-FLT_MAX) };
+        size_t i = 0;
+        for (; i + LaneCount <= count; i += LaneCount)
+        {
+            const float* group = data + i * 3;
+            for (size_t v = 0; v < 3; v++)
+            {
+                const Lanes values = Load(group + v * LaneCount);
+                minValues[v] = LanesMin(minValues[v], values);
+                maxValues[v] = LanesMax(maxValues[v], values);
+            }
+        }
+        float minLanes[3 * LaneCount], maxLanes[3 * LaneCount];
+        for (size_t v = 0; v < 3; v++)
+        {
+            Store(minLanes + v * LaneCount, minValues[v]);
+            Store(maxLanes + v * LaneCount, maxValues[v]);
+        }
+        Bounds local;
+        for (size_t k = 0; k < 3 * LaneCount; k++)
+        {
+            local.mMin[k % 3] = Min(local.mMin[k % 3], minLanes[k]);
+            local.mMax[k % 3] = Max(local.mMax[k % 3], maxLanes[k]);
+        }
+        for (; i < count; i++)
+        {
+            local.AddPoint(points[begin + i]);
+        }
+        bounds.AddBounds(local);
+    }
+
+    void AddRange(Bounds& bounds, const float* x, const float* y, const float* z, size_t begin, size_t end)
+    {
+        Lanes minX = Splat(FLT_MAX), minY = Splat(FLT_MAX), minZ = Splat(FLT_MAX);
+        Lanes maxX = Splat(-FLT_MAX), maxY = Splat(-FLT_MAX), maxZ = Splat(-FLT_MAX);
+        size_t i = begin;
+        for (; i + LaneCount <= end; i += LaneCount)
+        {
+            const Lanes px = Load(x + i), py = Load(y + i), pz = Load(z + i);
+            minX = LanesMin(minX, px);
+            minY = LanesMin(minY, py);
+            minZ = LanesMin(minZ, pz);
+            maxX = LanesMax(maxX, px);
+            maxY = LanesMax(maxY, py);
+            maxZ = LanesMax(maxZ, pz);
+        }
+        Bounds local = ReduceLanes(minX, minY, minZ, maxX, maxY, maxZ);
+        for (; i < end; i++)
+        {
+            local.AddPoint({ x[i], y[i], z[i] });
+        }
+        bounds.AddBounds(local);
+    }
+
+    // runs range(begin, end, bounds) over [0, count), in parallel for large counts
+    template<typename Range> void Dispatch(size_t count, Bounds* bounds, const Range& range)
+    {
+        if (count <= ParallelGrainSize)
+        {
+            range(0, count, bounds);
+            return;
+        }
+        std::mutex boundsMutex;
+        ParallelFor(count, ParallelGrainSize, [&](size_t begin, size_t end) {
+            Bounds chunkBounds;
+            range(begin, end, bounds ? &chunkBounds : nullptr);
+            if (bounds)
+            {
+                std::lock_guard<std::mutex> lock(boundsMutex);
+                bounds->AddBounds(chunkBounds);
+            }
+        });
+    }
+}
+
+void TransformPoints(const Mat4x4& matrix,
+                     const float* x, const float* y, const float* z,
+                     float* outX, float* outY, float* outZ,
+                     size_t count,
+                     Bounds* bounds)
+{
+    Dispatch(count, bounds, [&](size_t begin, size_t end, Bounds* rangeBounds) {
+        TransformRange<true>(matrix, x, y, z, outX, outY, outZ, begin, end, rangeBounds);
+    });
+}
+
+void TransformVectors(const Mat4x4& matrix,
+                      const float* x, const float* y, const float* z,
+                      float* outX, float* outY, float* outZ,
+                      size_t count)
+{
+    Dispatch(count, nullptr, [&](size_t begin, size_t end, Bounds*) {
+        TransformRange<false>(matrix, x, y, z, outX, outY, outZ, begin, end, nullptr);
+    });
+}
+
+void TransformPoints(const Mat4x4& matrix, const Vec3* points, Vec3* outPoints, size_t count, Bounds* bounds)
+{
+    Dispatch(count, bounds, [&](size_t begin, size_t end, Bounds* rangeBounds) {
+        TransformPackedRange<true>(matrix, points, outPoints, begin, end, rangeBounds);
+    });
+}
+
+void TransformVectors(const Mat4x4& matrix, const Vec3* vectors, Vec3* outVectors, size_t count)
+{
+    Dispatch(count, nullptr, [&](size_t begin, size_t end, Bounds*) {
+        TransformPackedRange<false>(matrix, vectors, outVectors, begin, end, nullptr);
+    });
+}
+
+void Bounds::AddPoints(const Vec3* points, size_t count)
+{
+    Dispatch(count, this, [&](size_t begin, size_t end, Bounds* rangeBounds) {
+        AddPackedRange(*rangeBounds, points, begin, end);
+    });
+}
+
+void Bounds::AddPoints(const float* x, const float* y, const float* z, size_t count)
+{
+    Dispatch(count, this, [&](size_t begin, size_t end, Bounds* rangeBounds) {
+        AddRange(*rangeBounds, x, y, z, begin, end);
+    });
+}
+
+void InverseBatch(const Mat4x4* in, Mat4x4* out, size_t count)
+{
+    ParallelFor(count, InverseGrainSize, [in, out](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            out[i].InverseAuto(in[i]);
+        }
+    });
+}
@@ -0,0 +1,53 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include "GeometryTypes.h"
+
+// Transforms of many points or vectors by one matrix, in a single pass over the arrays.
+// Points are transformed with w = 1, the projective column of the matrix is ignored.
+// Output arrays may be the input arrays. When bounds is not null, the transformed points are
+// added to it in the same pass. Large arrays are split over the worker threads (see ParallelFor).
+
+// structure of arrays: x[i], y[i], z[i]
+void TransformPoints(const Mat4x4& matrix,
+                     const float* x, const float* y, const float* z,
+                     float* outX, float* outY, float* outZ,
+                     size_t count,
+                     Bounds* bounds = nullptr);
+void TransformVectors(const Mat4x4& matrix,
+                      const float* x, const float* y, const float* z,
+                      float* outX, float* outY, float* outZ,
+                      size_t count);
+
+// packed Vec3
+void TransformPoints(const Mat4x4& matrix, const Vec3* points, Vec3* outPoints, size_t count, Bounds* bounds = nullptr);
+void TransformVectors(const Mat4x4& matrix, const Vec3* vectors, Vec3* outVectors, size_t count);
+
+// out[i] = inverse of in[i] through Mat4x4::InverseAuto, out may be in
+void InverseBatch(const Mat4x4* in, Mat4x4* out, size_t count);
@@ -1,3 +1,4 @@
+#include <assert.h>
 #include "GeometryTypes.h"
 
 ///////////////////////////////////////////////////////////////////////////////////////////////////
@@ -210,6 +211,143 @@ void Mat4x4::OrthoOffCenterLH(const float l, float r, float b, const float t, fl
     m[3][3] = 1.0f;
 }
 
+float Mat4x4::InverseGeneral()
+{
+#if defined(GEMONI_SSE)
+    // adjugate from the 2x2 minors of rows a, b (s) and rows c, d (c):
+    // inverse row i = sign * (Bj * Vk - ...) with Bj = (b[j], a[j], d[j], c[j]) and Vk = (ck, ck, sk, sk)
+    const __m128 a = _mm_loadu_ps(m16);
+    const __m128 b = _mm_loadu_ps(m16 + 4);
+    const __m128 c = _mm_loadu_ps(m16 + 8);
+    const __m128 d = _mm_loadu_ps(m16 + 12);
+
+    // s0..s3 = a0b1-a1b0, a0b2-a2b0, a0b3-a3b0, a1b2-a2b1, same for c0..c3 with c and d
+    const __m128 s0123 = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 0, 0, 0)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(2, 3, 2, 1))),
+                                    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 2, 1)), _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 0, 0))));
+    const __m128 c0123 = _mm_sub_ps(_mm_mul_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(1, 0, 0, 0)), _mm_shuffle_ps(d, d, _MM_SHUFFLE(2, 3, 2, 1))),
+                                    _mm_mul_ps(_mm_shuffle_ps(c, c, _MM_SHUFFLE(2, 3, 2, 1)), _mm_shuffle_ps(d, d, _MM_SHUFFLE(1, 0, 0, 0))));
+    // s4, s5, c4, c5 = a1b3-a3b1, a2b3-a3b2, c1d3-c3d1, c2d3-c3d2
+    const __m128 ac = _mm_shuffle_ps(a, c, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m128 bd = _mm_shuffle_ps(b, d, _MM_SHUFFLE(3, 2, 3, 2));
+    const __m128 ac12 = _mm_shuffle_ps(a, c, _MM_SHUFFLE(2, 1, 2, 1));
+    const __m128 bd12 = _mm_shuffle_ps(b, d, _MM_SHUFFLE(2, 1, 2, 1));
+    const __m128 s45c45 = _mm_sub_ps(_mm_mul_ps(ac12, _mm_shuffle_ps(bd, bd, _MM_SHUFFLE(3, 3, 1, 1))),
+                                     _mm_mul_ps(_mm_shuffle_ps(ac, ac, _MM_SHUFFLE(3, 3, 1, 1)), bd12));
+
+    const __m128 v0 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 v1 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(1, 1, 1, 1));
+    const __m128 v2 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(2, 2, 2, 2));
+    const __m128 v3 = _mm_shuffle_ps(c0123, s0123, _MM_SHUFFLE(3, 3, 3, 3));
+    const __m128 v4 = _mm_shuffle_ps(s45c45, s45c45, _MM_SHUFFLE(0, 0, 2, 2));
+    const __m128 v5 = _mm_shuffle_ps(s45c45, s45c45, _MM_SHUFFLE(1, 1, 3, 3));
+
+    const __m128 dc = _mm_shuffle_ps(d, c, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 ba0 = _mm_shuffle_ps(b, a, _MM_SHUFFLE(0, 0, 0, 0));
+    const __m128 b0 = _mm_shuffle_ps(ba0, dc, _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 b1 = _mm_shuffle_ps(_mm_shuffle_ps(b, a, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(d, c, _MM_SHUFFLE(1, 1, 1, 1)), _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 b2 = _mm_shuffle_ps(_mm_shuffle_ps(b, a, _MM_SHUFFLE(2, 2, 2, 2)), _mm_shuffle_ps(d, c, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+    const __m128 b3 = _mm_shuffle_ps(_mm_shuffle_ps(b, a, _MM_SHUFFLE(3, 3, 3, 3)), _mm_shuffle_ps(d, c, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+
+    const __m128 signA = _mm_setr_ps(1.f, -1.f, 1.f, -1.f);
+    const __m128 signB = _mm_setr_ps(-1.f, 1.f, -1.f, 1.f);
+    __m128 r0 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b1, v5), _mm_mul_ps(b2, v4)), _mm_mul_ps(b3, v3));
+    __m128 r1 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b0, v5), _mm_mul_ps(b2, v2)), _mm_mul_ps(b3, v1));
+    __m128 r2 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b0, v4), _mm_mul_ps(b1, v2)), _mm_mul_ps(b3, v0));
+    __m128 r3 = _mm_add_ps(_mm_sub_ps(_mm_mul_ps(b0, v3), _mm_mul_ps(b1, v1)), _mm_mul_ps(b2, v0));
+    r0 = _mm_mul_ps(r0, signA);
+    r1 = _mm_mul_ps(r1, signB);
+    r2 = _mm_mul_ps(r2, signA);
+    r3 = _mm_mul_ps(r3, signB);
+
+    // determinant: row a dot the first column of the adjugate
+    const __m128 column0 = _mm_movelh_ps(_mm_unpacklo_ps(r0, r1), _mm_unpacklo_ps(r2, r3));
+    __m128 dot = _mm_mul_ps(a, column0);
+    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+    dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+    const float det = _mm_cvtss_f32(dot);
+
+    const __m128 invDet = _mm_div_ps(_mm_set1_ps(1.f), dot);
+    _mm_storeu_ps(m16, _mm_mul_ps(r0, invDet));
+    _mm_storeu_ps(m16 + 4, _mm_mul_ps(r1, invDet));
+    _mm_storeu_ps(m16 + 8, _mm_mul_ps(r2, invDet));
+    _mm_storeu_ps(m16 + 12, _mm_mul_ps(r3, invDet));
+    return det;
+#else
+    float det;
+
+    // transpose matrix
+    float src[16];
+    for (int i = 0; i < 4; ++i)
+    {
+        src[i] = m16[i * 4];
+        src[i + 4] = m16[i * 4 + 1];
+        src[i + 8] = m16[i * 4 + 2];
+        src[i + 12] = m16[i * 4 + 3];
+    }
+
+    // calculate pairs for first 8 elements (cofactors)
+    float tmp[12]; // temp array for pairs
+    tmp[0] = src[10] * src[15];
+    tmp[1] = src[11] * src[14];
+    tmp[2] = src[9] * src[15];
+    tmp[3] = src[11] * src[13];
+    tmp[4] = src[9] * src[14];
+    tmp[5] = src[10] * src[13];
+    tmp[6] = src[8] * src[15];
+    tmp[7] = src[11] * src[12];
+    tmp[8] = src[8] * src[14];
+    tmp[9] = src[10] * src[12];
+    tmp[10] = src[8] * src[13];
+    tmp[11] = src[9] * src[12];
+
+    // calculate first 8 elements (cofactors)
+    m16[0] = (tmp[0] * src[5] + tmp[3] * src[6] + tmp[4] * src[7]) - (tmp[1] * src[5] + tmp[2] * src[6] + tmp[5] * src[7]);
+    m16[1] = (tmp[1] * src[4] + tmp[6] * src[6] + tmp[9] * src[7]) - (tmp[0] * src[4] + tmp[7] * src[6] + tmp[8] * src[7]);
+    m16[2] = (tmp[2] * src[4] + tmp[7] * src[5] + tmp[10] * src[7]) - (tmp[3] * src[4] + tmp[6] * src[5] + tmp[11] * src[7]);
+    m16[3] = (tmp[5] * src[4] + tmp[8] * src[5] + tmp[11] * src[6]) - (tmp[4] * src[4] + tmp[9] * src[5] + tmp[10] * src[6]);
+    m16[4] = (tmp[1] * src[1] + tmp[2] * src[2] + tmp[5] * src[3]) - (tmp[0] * src[1] + tmp[3] * src[2] + tmp[4] * src[3]);
+    m16[5] = (tmp[0] * src[0] + tmp[7] * src[2] + tmp[8] * src[3]) - (tmp[1] * src[0] + tmp[6] * src[2] + tmp[9] * src[3]);
+    m16[6] = (tmp[3] * src[0] + tmp[6] * src[1] + tmp[11] * src[3]) - (tmp[2] * src[0] + tmp[7] * src[1] + tmp[10] * src[3]);
+    m16[7] = (tmp[4] * src[0] + tmp[9] * src[1] + tmp[10] * src[2]) - (tmp[5] * src[0] + tmp[8] * src[1] + tmp[11] * src[2]);
+
+    // calculate pairs for second 8 elements (cofactors)
+    tmp[0] = src[2] * src[7];
+    tmp[1] = src[3] * src[6];
+    tmp[2] = src[1] * src[7];
+    tmp[3] = src[3] * src[5];
+    tmp[4] = src[1] * src[6];
+    tmp[5] = src[2] * src[5];
+    tmp[6] = src[0] * src[7];
+    tmp[7] = src[3] * src[4];
+    tmp[8] = src[0] * src[6];
+    tmp[9] = src[2] * src[4];
+    tmp[10] = src[0] * src[5];
+    tmp[11] = src[1] * src[4];
+
+    // calculate second 8 elements (cofactors)
+    m16[8] = (tmp[0] * src[13] + tmp[3] * src[14] + tmp[4] * src[15]) - (tmp[1] * src[13] + tmp[2] * src[14] + tmp[5] * src[15]);
+    m16[9] = (tmp[1] * src[12] + tmp[6] * src[14] + tmp[9] * src[15]) - (tmp[0] * src[12] + tmp[7] * src[14] + tmp[8] * src[15]);
+    m16[10] = (tmp[2] * src[12] + tmp[7] * src[13] + tmp[10] * src[15]) - (tmp[3] * src[12] + tmp[6] * src[13] + tmp[11] * src[15]);
+    m16[11] = (tmp[5] * src[12] + tmp[8] * src[13] + tmp[11] * src[14]) - (tmp[4] * src[12] + tmp[9] * src[13] + tmp[10] * src[14]);
+    m16[12] = (tmp[2] * src[10] + tmp[5] * src[11] + tmp[1] * src[9]) - (tmp[4] * src[11] + tmp[0] * src[9] + tmp[3] * src[10]);
+    m16[13] = (tmp[8] * src[11] + tmp[0] * src[8] + tmp[7] * src[10]) - (tmp[6] * src[10] + tmp[9] * src[11] + tmp[1] * src[8]);
+    m16[14] = (tmp[6] * src[9] + tmp[11] * src[11] + tmp[3] * src[8]) - (tmp[10] * src[11] + tmp[2] * src[8] + tmp[7] * src[9]);
+    m16[15] = (tmp[10] * src[10] + tmp[4] * src[8] + tmp[9] * src[9]) - (tmp[8] * src[9] + tmp[11] * src[10] + tmp[5] * src[8]);
+
+    // calculate determinant
+    det = src[0] * m16[0] + src[1] * m16[1] + src[2] * m16[2] + src[3] * m16[3];
+
+    // calculate matrix inverse
+    float invdet = 1 / det;
+    for (int j = 0; j < 16; ++j)
+    {
+        m16[j] *= invdet;
+    }
+
+    return det;
+#endif
+}
+
 float Mat4x4::Inverse(const Mat4x4& srcMatrix, bool affine)
 {
     *this = srcMatrix;
@@ -251,78 +389,99 @@ float Mat4x4::Inverse(bool affine)
     }
     else
     {
-        // transpose matrix
-        float src[16];
-        for (int i = 0; i < 4; ++i)
-        {
-            src[i] = m16[i * 4];
-            src[i + 4] = m16[i * 4 + 1];
-            src[i + 8] = m16[i * 4 + 2];
-            src[i + 12] = m16[i * 4 + 3];
-        }
+        det = InverseGeneral();
+    }
+
+    return det;
+
+}
+
+void Mat4x4::rotationQuaternion(const Vec4& q)
+{
+    // unit quaternion (x, y, z, w), same convention as RotationAxis
+    const float xx = q.x * q.x, yy = q.y * q.y, zz = q.z * q.z;
+    const float xy = q.x * q.y, xz = q.x * q.z, yz = q.y * q.z;
+    const float wx = q.w * q.x, wy = q.w * q.y, wz = q.w * q.z;
+
+    m[0][0] = 1.f - 2.f * (yy + zz);
+    m[0][1] = 2.f * (xy + wz);
+    m[0][2] = 2.f * (xz - wy);
+    m[0][3] = 0.f;
+    m[1][0] = 2.f * (xy - wz);
+    m[1][1] = 1.f - 2.f * (xx + zz);
+    m[1][2] = 2.f * (yz + wx);
+    m[1][3] = 0.f;
+    m[2][0] = 2.f * (xz + wy);
+    m[2][1] = 2.f * (yz - wx);
+    m[2][2] = 1.f - 2.f * (xx + yy);
+    m[2][3] = 0.f;
+    m[3][0] = 0.f;
+    m[3][1] = 0.f;
+    m[3][2] = 0.f;
+    m[3][3] = 1.f;
+}
 
-        // calculate pairs for first 8 elements (cofactors)
-        float tmp[12]; // temp array for pairs
-        tmp[0] = src[10] * src[15];
-        tmp[1] = src[11] * src[14];
-        tmp[2] = src[9] * src[15];
-        tmp[3] = src[11] * src[13];
-        tmp[4] = src[9] * src[14];
-        tmp[5] = src[10] * src[13];
-        tmp[6] = src[8] * src[15];
-        tmp[7] = src[11] * src[12];
-        tmp[8] = src[8] * src[14];
-        tmp[9] = src[10] * src[12];
-        tmp[10] = src[8] * src[13];
-        tmp[11] = src[9] * src[12];
-
-        // calculate first 8 elements (cofactors)
-        m16[0] = (tmp[0] * src[5] + tmp[3] * src[6] + tmp[4] * src[7]) - (tmp[1] * src[5] + tmp[2] * src[6] + tmp[5] * src[7]);
-        m16[1] = (tmp[1] * src[4] + tmp[6] * src[6] + tmp[9] * src[7]) - (tmp[0] * src[4] + tmp[7] * src[6] + tmp[8] * src[7]);
-        m16[2] = (tmp[2] * src[4] + tmp[7] * src[5] + tmp[10] * src[7]) - (tmp[3] * src[4] + tmp[6] * src[5] + tmp[11] * src[7]);
-        m16[3] = (tmp[5] * src[4] + tmp[8] * src[5] + tmp[11] * src[6]) - (tmp[4] * src[4] + tmp[9] * src[5] + tmp[10] * src[6]);
-        m16[4] = (tmp[1] * src[1] + tmp[2] * src[2] + tmp[5] * src[3]) - (tmp[0] * src[1] + tmp[3] * src[2] + tmp[4] * src[3]);
-        m16[5] = (tmp[0] * src[0] + tmp[7] * src[2] + tmp[8] * src[3]) - (tmp[1] * src[0] + tmp[6] * src[2] + tmp[9] * src[3]);
-        m16[6] = (tmp[3] * src[0] + tmp[6] * src[1] + tmp[11] * src[3]) - (tmp[2] * src[0] + tmp[7] * src[1] + tmp[10] * src[3]);
-        m16[7] = (tmp[4] * src[0] + tmp[9] * src[1] + tmp[10] * src[2]) - (tmp[5] * src[0] + tmp[8] * src[1] + tmp[11] * src[2]);
-
-        // calculate pairs for second 8 elements (cofactors)
-        tmp[0] = src[2] * src[7];
-        tmp[1] = src[3] * src[6];
-        tmp[2] = src[1] * src[7];
-        tmp[3] = src[3] * src[5];
-        tmp[4] = src[1] * src[6];
-        tmp[5] = src[2] * src[5];
-        tmp[6] = src[0] * src[7];
-        tmp[7] = src[3] * src[4];
-        tmp[8] = src[0] * src[6];
-        tmp[9] = src[2] * src[4];
-        tmp[10] = src[0] * src[5];
-        tmp[11] = src[1] * src[4];
-
-        // calculate second 8 elements (cofactors)
-        m16[8] = (tmp[0] * src[13] + tmp[3] * src[14] + tmp[4] * src[15]) - (tmp[1] * src[13] + tmp[2] * src[14] + tmp[5] * src[15]);
-        m16[9] = (tmp[1] * src[12] + tmp[6] * src[14] + tmp[9] * src[15]) - (tmp[0] * src[12] + tmp[7] * src[14] + tmp[8] * src[15]);
-        m16[10] = (tmp[2] * src[12] + tmp[7] * src[13] + tmp[10] * src[15]) - (tmp[3] * src[12] + tmp[6] * src[13] + tmp[11] * src[15]);
-        m16[11] = (tmp[5] * src[12] + tmp[8] * src[13] + tmp[11] * src[14]) - (tmp[4] * src[12] + tmp[9] * src[13] + tmp[10] * src[14]);
-        m16[12] = (tmp[2] * src[10] + tmp[5] * src[11] + tmp[1] * src[9]) - (tmp[4] * src[11] + tmp[0] * src[9] + tmp[3] * src[10]);
-        m16[13] = (tmp[8] * src[11] + tmp[0] * src[8] + tmp[7] * src[10]) - (tmp[6] * src[10] + tmp[9] * src[11] + tmp[1] * src[8]);
-        m16[14] = (tmp[6] * src[9] + tmp[11] * src[11] + tmp[3] * src[8]) - (tmp[10] * src[11] + tmp[2] * src[8] + tmp[7] * src[9]);
-        m16[15] = (tmp[10] * src[10] + tmp[4] * src[8] + tmp[9] * src[9]) - (tmp[8] * src[9] + tmp[11] * src[10] + tmp[5] * src[8]);
-
-        // calculate determinant
-        det = src[0] * m16[0] + src[1] * m16[1] + src[2] * m16[2] + src[3] * m16[3];
-
-        // calculate matrix inverse
-        float invdet = 1 / det;
-        for (int j = 0; j < 16; ++j)
+void Mat4x4::RotationYawPitchRoll(const float yaw, const float pitch, const float roll)
+{
+    // roll around z, then pitch around x, then yaw around y
+    Mat4x4 rotation;
+    RotationZ(roll);
+    rotation.RotationX(pitch);
+    Multiply(rotation);
+    rotation.RotationY(yaw);
+    Multiply(rotation);
+}
+
+bool Mat4x4::IsRigid(float epsilon) const
+{
+    if (!IsAffine())
+    {
+        return false;
+    }
+    for (int i = 0; i < 3; i++)
+    {
+        for (int j = i; j < 3; j++)
         {
-            m16[j] *= invdet;
+            const float dot = m[i][0] * m[j][0] + m[i][1] * m[j][1] + m[i][2] * m[j][2];
+            if (fabsf(dot - ((i == j) ? 1.f : 0.f)) > epsilon)
+            {
+                return false;
+            }
         }
     }
+    return true;
+}
 
+float Mat4x4::InverseRigid(const Mat4x4& srcMatrix)
+{
+    *this = srcMatrix;
+    return InverseRigid();
+}
+
+float Mat4x4::InverseRigid()
+{
+    assert(IsRigid(1e-3f));
+    const float det = GetDeterminant();
+    const Vec4 translation = V.position;
+    V.position.Set(0.f, 0.f, 0.f, 1.f);
+    transpose();
+    // -t * transposed rotation
+    for (int j = 0; j < 3; j++)
+    {
+        m[3][j] = -(translation.x * m[0][j] + translation.y * m[1][j] + translation.z * m[2][j]);
+    }
     return det;
+}
 
+float Mat4x4::InverseAuto(const Mat4x4& srcMatrix)
+{
+    *this = srcMatrix;
+    return InverseAuto();
+}
+
+float Mat4x4::InverseAuto()
+{
+    return Inverse(IsAffine());
 }
 
 void Bounds::AddPoint(const Vec3 pt)
@@ -337,13 +496,29 @@ void Bounds::AddPoint(const Vec3 pt)
 
 void Bounds::AddBounds(const Bounds bounds, const Mat4x4& matrix)
 {
-    for (int i = 0; i < 8; i++)
+    if (bounds.IsEmpty())
+    {
+        return;
+    }
+    // Arvo: transformed center plus the extents projected on the absolute matrix, instead of 8 corners.
+    // x, y, z of a transformed point don't depend on the projective column so the result is the same.
+    const float center[3] = { (bounds.mMin.x + bounds.mMax.x) * 0.5f,
+                              (bounds.mMin.y + bounds.mMax.y) * 0.5f,
+                              (bounds.mMin.z + bounds.mMax.z) * 0.5f };
+    const float extent[3] = { (bounds.mMax.x - bounds.mMin.x) * 0.5f,
+                              (bounds.mMax.y - bounds.mMin.y) * 0.5f,
+                              (bounds.mMax.z - bounds.mMin.z) * 0.5f };
+    for (int j = 0; j < 3; j++)
     {
-        Vec4 p((i & 1) ? bounds.mMax.x : bounds.mMin.x,
-            (i & 2) ? bounds.mMax.y : bounds.mMin.y,
-            (i & 4) ? bounds.mMax.z : bounds.mMin.z);
-        p.TransformPoint(matrix);
-        AddPoint({ p.x, p.y, p.z });
+        float newCenter = matrix.m[3][j];
+        float newExtent = 0.f;
+        for (int i = 0; i < 3; i++)
+        {
+            newCenter += center[i] * matrix.m[i][j];
+            newExtent += extent[i] * fabsf(matrix.m[i][j]);
+        }
+        mMin[j] = Min(mMin[j], newCenter - newExtent);
+        mMax[j] = Max(mMax[j], newCenter + newExtent);
     }
 }
 
@@ -1,9 +1,19 @@
-#pragma
+#pragma once
 #include <float.h>
 #include <math.h>
 #include <memory.h>
 #include "Utils.h"
 
+// SIMD paths are chosen at compile time, define GEMONI_NO_SIMD to build the scalar code only.
+// Types keep their scalar layout (they are stored in parameter blocks) so every access is unaligned.
+#if !defined(GEMONI_NO_SIMD) && (defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#define GEMONI_SSE 1
+#include <emmintrin.h>
+#elif !defined(GEMONI_NO_SIMD) && (defined(__ARM_NEON) || defined(__ARM_NEON__))
+#define GEMONI_NEON 1
+#include <arm_neon.h>
+#endif
+
 struct Mat4x4;
 
 struct iVec2
@@ -385,27 +395,49 @@ inline float Dot(const Vec4& v1, const Vec4& v2)
 }
 
 
+// r = a * b, r may be a or b
 inline void FPU_MatrixF_x_MatrixF(const float* a, const float* b, float* r)
 {
-    r[0] = a[0] * b[0] + a[1] * b[4] + a[2] * b[8] + a[3] * b[12];
-    r[1] = a[0] * b[1] + a[1] * b[5] + a[2] * b[9] + a[3] * b[13];
-    r[2] = a[0] * b[2] + a[1] * b[6] + a[2] * b[10] + a[3] * b[14];
-    r[3] = a[0] * b[3] + a[1] * b[7] + a[2] * b[11] + a[3] * b[15];
-
-    r[4] = a[4] * b[0] + a[5] * b[4] + a[6] * b[8] + a[7] * b[12];
-    r[5] = a[4] * b[1] + a[5] * b[5] + a[6] * b[9] + a[7] * b[13];
-    r[6] = a[4] * b[2] + a[5] * b[6] + a[6] * b[10] + a[7] * b[14];
-    r[7] = a[4] * b[3] + a[5] * b[7] + a[6] * b[11] + a[7] * b[15];
-
-    r[8] = a[8] * b[0] + a[9] * b[4] + a[10] * b[8] + a[11] * b[12];
-    r[9] = a[8] * b[1] + a[9] * b[5] + a[10] * b[9] + a[11] * b[13];
-    r[10] = a[8] * b[2] + a[9] * b[6] + a[10] * b[10] + a[11] * b[14];
-    r[11] = a[8] * b[3] + a[9] * b[7] + a[10] * b[11] + a[11] * b[15];
-
-    r[12] = a[12] * b[0] + a[13] * b[4] + a[14] * b[8] + a[15] * b[12];
-    r[13] = a[12] * b[1] + a[13] * b[5] + a[14] * b[9] + a[15] * b[13];
-    r[14] = a[12] * b[2] + a[13] * b[6] + a[14] * b[10] + a[15] * b[14];
-    r[15] = a[12] * b[3] + a[13] * b[7] + a[14] * b[11] + a[15] * b[15];
+#if defined(GEMONI_SSE)
+    const __m128 b0 = _mm_loadu_ps(b);
+    const __m128 b1 = _mm_loadu_ps(b + 4);
+    const __m128 b2 = _mm_loadu_ps(b + 8);
+    const __m128 b3 = _mm_loadu_ps(b + 12);
+    for (int i = 0; i < 16; i += 4)
+    {
+        const __m128 row = _mm_loadu_ps(a + i);
+        __m128 res = _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(0, 0, 0, 0)), b0);
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(1, 1, 1, 1)), b1));
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(2, 2, 2, 2)), b2));
+        res = _mm_add_ps(res, _mm_mul_ps(_mm_shuffle_ps(row, row, _MM_SHUFFLE(3, 3, 3, 3)), b3));
+        _mm_storeu_ps(r + i, res);
+    }
+#elif defined(GEMONI_NEON)
+    const float32x4_t b0 = vld1q_f32(b);
+    const float32x4_t b1 = vld1q_f32(b + 4);
+    const float32x4_t b2 = vld1q_f32(b + 8);
+    const float32x4_t b3 = vld1q_f32(b + 12);
+    for (int i = 0; i < 16; i += 4)
+    {
+        const float32x4_t row = vld1q_f32(a + i);
+        float32x4_t res = vmulq_lane_f32(b0, vget_low_f32(row), 0);
+        res = vmlaq_lane_f32(res, b1, vget_low_f32(row), 1);
+        res = vmlaq_lane_f32(res, b2, vget_high_f32(row), 0);
+        res = vmlaq_lane_f32(res, b3, vget_high_f32(row), 1);
+        vst1q_f32(r + i, res);
+    }
+#else
+    float bc[16];
+    memcpy(bc, b, sizeof(bc));
+    for (int i = 0; i < 16; i += 4)
+    {
+        const float a0 = a[i], a1 = a[i + 1], a2 = a[i + 2], a3 = a[i + 3];
+        r[i] = a0 * bc[0] + a1 * bc[4] + a2 * bc[8] + a3 * bc[12];
+        r[i + 1] = a0 * bc[1] + a1 * bc[5] + a2 * bc[9] + a3 * bc[13];
+        r[i + 2] = a0 * bc[2] + a1 * bc[6] + a2 * bc[10] + a3 * bc[14];
+        r[i + 3] = a0 * bc[3] + a1 * bc[7] + a2 * bc[11] + a3 * bc[15];
+    }
+#endif
 }
 
 
@@ -592,10 +624,7 @@ public:
 
     inline Mat4x4& operator*=(const Mat4x4& mat)
     {
-        Mat4x4 tmpMat;
-        tmpMat = *this;
-        tmpMat.Multiply(mat);
-        *this = tmpMat;
+        Multiply(mat);
         return *this;
     }
     inline Mat4x4 operator*(const Mat4x4& mat) const
@@ -607,10 +636,7 @@ public:
 
     inline void Multiply(const Mat4x4& matrix)
     {
-        Mat4x4 tmp;
-        tmp = *this;
-
-        FPU_MatrixF_x_MatrixF((float*)&tmp, (float*)&matrix, (float*)this);
+        FPU_MatrixF_x_MatrixF((float*)this, (float*)&matrix, (float*)this);
     }
 
     inline void Multiply(const Mat4x4& m1, const Mat4x4& m2)
@@ -635,6 +661,20 @@ public:
 
     float Inverse(const Mat4x4& srcMatrix, bool affine = false);
     float Inverse(bool affine = false);
+    // 3x3 inverse for affine matrices, general inverse otherwise. Rigidity isn't detected: testing it
+    // costs more than the affine inverse, call InverseRigid when the matrix is known to be rigid.
+    float InverseAuto(const Mat4x4& srcMatrix);
+    float InverseAuto();
+    // transpose of the 3x3 part and rotated translation, for matrices where IsRigid is true
+    float InverseRigid(const Mat4x4& srcMatrix);
+    float InverseRigid();
+    // last column is (0, 0, 0, 1)
+    bool IsAffine() const
+    {
+        return m[0][3] == 0.f && m[1][3] == 0.f && m[2][3] == 0.f && m[3][3] == 1.f;
+    }
+    // affine with an orthonormal 3x3 part: rotation, possibly a reflection, and translation
+    bool IsRigid(float epsilon = 1e-5f) const;
     void Identity()
     {
         V.right.Set(1.f, 0.f, 0.f, 0.f);
@@ -644,15 +684,34 @@ public:
     }
     inline void transpose()
     {
-        Mat4x4 tmpm;
+#if defined(GEMONI_SSE)
+        __m128 r0 = _mm_loadu_ps(m16);
+        __m128 r1 = _mm_loadu_ps(m16 + 4);
+        __m128 r2 = _mm_loadu_ps(m16 + 8);
+        __m128 r3 = _mm_loadu_ps(m16 + 12);
+        _MM_TRANSPOSE4_PS(r0, r1, r2, r3);
+        _mm_storeu_ps(m16, r0);
+        _mm_storeu_ps(m16 + 4, r1);
+        _mm_storeu_ps(m16 + 8, r2);
+        _mm_storeu_ps(m16 + 12, r3);
+#elif defined(GEMONI_NEON)
+        // deinterleaving load reads the columns
+        const float32x4x4_t columns = vld4q_f32(m16);
+        vst1q_f32(m16, columns.val[0]);
+        vst1q_f32(m16 + 4, columns.val[1]);
+        vst1q_f32(m16 + 8, columns.val[2]);
+        vst1q_f32(m16 + 12, columns.val[3]);
+#else
         for (int l = 0; l < 4; l++)
         {
-            for (int c = 0; c < 4; c++)
+            for (int c = l + 1; c < 4; c++)
             {
-                tmpm.m[l][c] = m[c][l];
+                float v = m[l][c];
+                m[l][c] = m[c][l];
+                m[c][l] = v;
             }
         }
-        (*this) = tmpm;
+#endif
     }
     void RotationAxis(const Vec4& axis, float angle);
     /*
@@ -672,11 +731,25 @@ public:
         V.up.Normalize();
         V.dir.Normalize();
     }
+
+private:
+    float InverseGeneral();
 };
 
 
 inline void Vec4::TransformVector(const Mat4x4& matrix)
 {
+#if defined(GEMONI_SSE)
+    __m128 res = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(matrix.m16));
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(matrix.m16 + 4)));
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(matrix.m16 + 8)));
+    _mm_storeu_ps(&x, res);
+#elif defined(GEMONI_NEON)
+    float32x4_t res = vmulq_n_f32(vld1q_f32(matrix.m16), x);
+    res = vmlaq_n_f32(res, vld1q_f32(matrix.m16 + 4), y);
+    res = vmlaq_n_f32(res, vld1q_f32(matrix.m16 + 8), z);
+    vst1q_f32(&x, res);
+#else
     Vec4 out;
 
     out.x = x * matrix.m[0][0] + y * matrix.m[1][0] + z * matrix.m[2][0];
@@ -688,10 +761,23 @@ inline void Vec4::TransformVector(const Mat4x4& matrix)
     y = out.y;
     z = out.z;
     w = out.w;
+#endif
 }
 
 inline void Vec4::TransformPoint(const Mat4x4& matrix)
 {
+#if defined(GEMONI_SSE)
+    __m128 res = _mm_mul_ps(_mm_set1_ps(x), _mm_loadu_ps(matrix.m16));
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(y), _mm_loadu_ps(matrix.m16 + 4)));
+    res = _mm_add_ps(res, _mm_mul_ps(_mm_set1_ps(z), _mm_loadu_ps(matrix.m16 + 8)));
+    res = _mm_add_ps(res, _mm_loadu_ps(matrix.m16 + 12));
+    _mm_storeu_ps(&x, res);
+#elif defined(GEMONI_NEON)
+    float32x4_t res = vmlaq_n_f32(vld1q_f32(matrix.m16 + 12), vld1q_f32(matrix.m16), x);
+    res = vmlaq_n_f32(res, vld1q_f32(matrix.m16 + 4), y);
+    res = vmlaq_n_f32(res, vld1q_f32(matrix.m16 + 8), z);
+    vst1q_f32(&x, res);
+#else
     Vec4 out;
 
     out.x = x * matrix.m[0][0] + y * matrix.m[1][0] + z * matrix.m[2][0] + matrix.m[3][0];
@@ -703,6 +789,7 @@ inline void Vec4::TransformPoint(const Mat4x4& matrix)
     y = out.y;
     z = out.z;
     w = out.w;
+#endif
 }
 
 
@@ -754,6 +841,23 @@ struct Bounds
     Vec3 mMax{ -FLT_MAX, -FLT_MAX, -FLT_MAX };
 
     void AddPoint(const Vec3 pt);
+    // SIMD reductions, large arrays are split over the worker threads. See GeometryBatch.cpp
+    void AddPoints(const Vec3* points, size_t count);
+    void AddPoints(const float* x, const float* y, const float* z, size_t count);
+    void AddBounds(const Bounds& bounds)
+    {
+        mMin.x = Min(mMin.x, bounds.mMin.x);
+        mMin.y = Min(mMin.y, bounds.mMin.y);
+        mMin.z = Min(mMin.z, bounds.mMin.z);
+        mMax.x = Max(mMax.x, bounds.mMax.x);
+        mMax.y = Max(mMax.y, bounds.mMax.y);
+        mMax.z = Max(mMax.z, bounds.mMax.z);
+    }
+    // adds bounds transformed by matrix, the box enclosing its 8 transformed corners
     void AddBounds(const Bounds bounds, const Mat4x4& matrix);
+    bool IsEmpty() const
+    {
+        return mMin.x > mMax.x || mMin.y > mMax.y || mMin.z > mMax.z;
+    }
     Vec4 Center() const;
 };
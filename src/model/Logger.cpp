@@ -0,0 +1,624 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "Logger.h"
+#include "Utils.h"
+
+enum LogSlotKind
+{
+    LogSlot_Text,     // formatted text in mPayload
+    LogSlot_HeapText, // formatted text too long for a slot, malloc'ed
+    LogSlot_Deferred, // mFormat and captured arguments in mPayload
+};
+
+enum LogArgumentTag
+{
+    LogArgument_Signed,
+    LogArgument_Unsigned,
+    LogArgument_Double,
+    LogArgument_Pointer,
+    LogArgument_String, // uint16_t length then the characters
+};
+
+static const size_t LogSlotSize = 256;
+static const size_t LogSlotCount = 8192; // power of 2
+
+struct LogSlot
+{
+    std::atomic<size_t> mSequence;
+    uint8_t mSeverity;
+    uint8_t mKind;
+    uint16_t mSize;
+    union
+    {
+        const char* mFormat;
+        char* mHeapText;
+    };
+    uint8_t mPayload[LogSlotSize - sizeof(std::atomic<size_t>) - 4 - sizeof(char*)];
+};
+
+static const size_t LogPayloadSize = sizeof(LogSlot::mPayload);
+
+static const char* SeverityPrefix(int severity)
+{
+    static const char* prefixes[] = { "Debug: ", "", "Warning: ", "Error: " };
+    return prefixes[severity];
+}
+
+static std::vector<LogOutput> outputs;
+
+// Bounded multi producer queue (Vyukov): a slot sequence tells if it is free for the producer
+// at that position or ready for the consumer.
+struct Logger
+{
+    Logger()
+    {
+        mSlots = new LogSlot[LogSlotCount];
+        for (size_t i = 0; i < LogSlotCount; i++)
+        {
+            mSlots[i].mSequence.store(i, std::memory_order_relaxed);
+        }
+        mFile = fopen("log.txt", "wt");
+        mbRunning = true;
+        mThread = std::thread([this]() { WriterLoop(); });
+        atexit([]() { GetLogger().Stop(); });
+    }
+
+    static Logger& GetLogger()
+    {
+        // never deleted, messages logged from static destructors are written synchronously
+        static Logger* logger = new Logger;
+        return *logger;
+    }
+
+    LogSlot* Claim(size_t& position)
+    {
+        if (!mbRunning.load(std::memory_order_acquire))
+        {
+            return nullptr;
+        }
+        position = mEnqueue.load(std::memory_order_relaxed);
+        while (true)
+        {
+            LogSlot* slot = &mSlots[position & (LogSlotCount - 1)];
+            const size_t sequence = slot->mSequence.load(std::memory_order_acquire);
+            const intptr_t difference = intptr_t(sequence) - intptr_t(position);
+            if (!difference)
+            {
+                if (mEnqueue.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                {
+                    return slot;
+                }
+            }
+            else if (difference < 0)
+            {
+                mDropped.fetch_add(1, std::memory_order_relaxed);
+                mDroppedTotal.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+            else
+            {
+                position = mEnqueue.load(std::memory_order_relaxed);
+            }
+        }
+    }
+
+    void Commit(LogSlot* slot, size_t position)
+    {
+        slot->mSequence.store(position + 1, std::memory_order_release);
+        if (mbWriterWaiting.load(std::memory_order_relaxed) && mbWriterWaiting.exchange(false))
+        {
+            mWake.notify_one();
+        }
+    }
+
+    void WriterLoop()
+    {
+        std::string batch;
+        std::string message;
+        while (true)
+        {
+            batch.clear();
+            size_t written = 0;
+            while (true)
+            {
+                LogSlot* slot = &mSlots[mDequeue & (LogSlotCount - 1)];
+                if (slot->mSequence.load(std::memory_order_acquire) != mDequeue + 1)
+                {
+                    break;
+                }
+                message = SeverityPrefix(slot->mSeverity);
+                switch (slot->mKind)
+                {
+                case LogSlot_Text:
+                    message.append((const char*)slot->mPayload, slot->mSize);
+                    break;
+                case LogSlot_HeapText:
+                    message.append(slot->mHeapText);
+                    free(slot->mHeapText);
+                    break;
+                case LogSlot_Deferred:
+                    FormatDeferred(slot->mFormat, slot->mPayload, slot->mSize, message);
+                    break;
+                }
+                slot->mSequence.store(mDequeue + LogSlotCount, std::memory_order_release);
+                mDequeue++;
+                written++;
+                Write(batch, message);
+            }
+            const uint64_t dropped = mDropped.exchange(0);
+            if (dropped)
+            {
+                char text[64];
+                snprintf(text, sizeof(text), "%llu log messages dropped\n", (unsigned long long)dropped);
+                Write(batch, text);
+            }
+            if (mFile && !batch.empty())
+            {
+                fwrite(batch.data(), 1, batch.size(), mFile);
+                fflush(mFile);
+            }
+
+            std::unique_lock<std::mutex> lock(mMutex);
+            mWritten = mDequeue;
+            mFlushed.notify_all();
+            if (written)
+            {
+                continue;
+            }
+            if (mEnqueue.load(std::memory_order_acquire) != mDequeue)
+            {
+                // a producer is filling the next slot
+                lock.unlock();
+                std::this_thread::yield();
+                continue;
+            }
+            if (mbStop)
+            {
+                return;
+            }
+            mbWriterWaiting = true;
+            mWake.wait_for(lock, std::chrono::milliseconds(10), [this]() {
+                return mbStop || mbFlushRequested || mEnqueue.load(std::memory_order_acquire) != mDequeue;
+            });
+            mbWriterWaiting = false;
+            mbFlushRequested = false;
+        }
+    }
+
+    void Write(std::string& batch, const std::string& message)
+    {
+        batch += message;
+        std::lock_guard<std::mutex> lock(mOutputMutex);
+        for (auto output : outputs)
+        {
+            output(message.c_str());
+        }
+    }
+
+    void Flush()
+    {
+        const size_t target = mEnqueue.load(std::memory_order_acquire);
+        std::unique_lock<std::mutex> lock(mMutex);
+        mbFlushRequested = true;
+        mWake.notify_one();
+        mFlushed.wait(lock, [&]() { return mWritten >= target || !mbRunning; });
+    }
+
+    void Stop()
+    {
+        mbRunning = false;
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mbStop = true;
+        }
+        mWake.notify_one();
+        if (mThread.joinable())
+        {
+            mThread.join();
+        }
+        mFlushed.notify_all();
+    }
+
+    // Used once the log thread is stopped
+    void WriteSynchronous(const char* text)
+    {
+        std::lock_guard<std::mutex> lock(mOutputMutex);
+        if (mFile)
+        {
+            fputs(text, mFile);
+            fflush(mFile);
+        }
+        for (auto output : outputs)
+        {
+            output(text);
+        }
+    }
+
+    static void FormatDeferred(const char* format, const uint8_t* arguments, size_t size, std::string& message);
+
+    LogSlot* mSlots;
+    std::atomic<size_t> mEnqueue{ 0 };
+    size_t mDequeue{ 0 };
+    std::atomic<uint64_t> mDropped{ 0 }; // since the last batch
+    std::atomic<uint64_t> mDroppedTotal{ 0 };
+    std::atomic<bool> mbRunning{ false };
+    std::atomic<bool> mbWriterWaiting{ false };
+
+    std::thread mThread;
+    std::mutex mMutex;
+    std::mutex mOutputMutex;
+    std::condition_variable mWake;
+    std::condition_variable mFlushed;
+    size_t mWritten{ 0 };
+    bool mbFlushRequested{ false };
+    bool mbStop{ false };
+    FILE* mFile;
+};
+
+struct LogArgumentValue
+{
+    uint8_t mTag;
+    union
+    {
+        int64_t mSigned;
+        uint64_t mUnsigned;
+        double mDouble;
+        const void* mPointer;
+    };
+    std::string mString;
+};
+
+static bool ReadArgument(const uint8_t*& arguments, const uint8_t* end, LogArgumentValue& value)
+{
+    if (arguments >= end)
+    {
+        return false;
+    }
+    value.mTag = *arguments++;
+    if (value.mTag == LogArgument_String)
+    {
+        uint16_t length;
+        memcpy(&length, arguments, sizeof(uint16_t));
+        arguments += sizeof(uint16_t);
+        value.mString.assign((const char*)arguments, length);
+        arguments += length;
+    }
+    else
+    {
+        memcpy(&value.mUnsigned, arguments, sizeof(uint64_t));
+        arguments += sizeof(uint64_t);
+    }
+    return true;
+}
+
+void Logger::FormatDeferred(const char* format, const uint8_t* arguments, size_t size, std::string& message)
+{
+    const uint8_t* end = arguments + size;
+    LogArgumentValue value;
+    char spec[32];
+    char text[512];
+    while (*format)
+    {
+        if (*format != '%')
+        {
+            const char* literal = format;
+            while (*format && *format != '%')
+            {
+                format++;
+            }
+            message.append(literal, format);
+            continue;
+        }
+        if (format[1] == '%')
+        {
+            message += '%';
+            format += 2;
+            continue;
+        }
+
+        // %[flags][width][.precision][length]conversion, length modifiers are replaced by the captured type
+        const char* start = format++;
+        size_t specLength = 0;
+        spec[specLength++] = '%';
+        while (*format && strchr("-+ #0123456789.", *format) && specLength < sizeof(spec) - 4)
+        {
+            spec[specLength++] = *format++;
+        }
+        while (*format && strchr("hlLqjzt", *format))
+        {
+            format++;
+        }
+        const char conversion = *format;
+        if (!conversion)
+        {
+            message.append(start);
+            return;
+        }
+        format++;
+        if (!ReadArgument(arguments, end, value))
+        {
+            message.append(start, format);
+            continue;
+        }
+        int length = 0;
+        switch (conversion)
+        {
+        case 'd':
+        case 'i':
+        case 'u':
+        case 'o':
+        case 'x':
+        case 'X':
+        case 'c':
+            if (value.mTag == LogArgument_Double)
+            {
+                value.mSigned = int64_t(value.mDouble);
+            }
+            if (conversion == 'c')
+            {
+                spec[specLength++] = 'c';
+                spec[specLength] = 0;
+                length = snprintf(text, sizeof(text), spec, int(value.mSigned));
+            }
+            else
+            {
+                spec[specLength++] = 'l';
+                spec[specLength++] = 'l';
+                spec[specLength++] = conversion;
+                spec[specLength] = 0;
+                length = snprintf(text, sizeof(text), spec, (long long)value.mSigned);
+            }
+            break;
+        case 'f':
+        case 'F':
+        case 'e':
+        case 'E':
+        case 'g':
+        case 'G':
+        case 'a':
+        case 'A':
+            if (value.mTag == LogArgument_Signed)
+            {
+                value.mDouble = double(value.mSigned);
+            }
+            else if (value.mTag == LogArgument_Unsigned)
+            {
+                value.mDouble = double(value.mUnsigned);
+            }
+            spec[specLength++] = conversion;
+            spec[specLength] = 0;
+            length = snprintf(text, sizeof(text), spec, value.mDouble);
+            break;
+        case 's':
+            if (value.mTag != LogArgument_String)
+            {
+                message.append(start, format);
+                continue;
+            }
+            spec[specLength++] = 's';
+            spec[specLength] = 0;
+            if (specLength == 2)
+            {
+                message += value.mString;
+                continue;
+            }
+            length = snprintf(text, sizeof(text), spec, value.mString.c_str());
+            break;
+        case 'p':
+            length = snprintf(text, sizeof(text), "%p", value.mPointer);
+            break;
+        default:
+            message.append(start, format);
+            continue;
+        }
+        if (length > 0)
+        {
+            message.append(text, Min(size_t(length), sizeof(text) - 1));
+        }
+    }
+}
+
+void FlushLog()
+{
+    Logger::GetLogger().Flush();
+}
+
+uint64_t GetDroppedLogCount()
+{
+    return Logger::GetLogger().mDroppedTotal.load(std::memory_order_relaxed);
+}
+
+LogCapture::LogCapture(LogSeverity severity, const char* format)
+{
+    Logger& logger = Logger::GetLogger();
+    mbSynchronous = false;
+    mSlot = logger.Claim(mPosition);
+    if (!mSlot && !logger.mbRunning)
+    {
+        // log thread stopped: captured in a slot of this thread, formatted and written by the destructor
+        static thread_local LogSlot synchronousSlot;
+        mSlot = &synchronousSlot;
+        mbSynchronous = true;
+    }
+    if (mSlot)
+    {
+        mSlot->mSeverity = uint8_t(severity);
+        mSlot->mKind = LogSlot_Deferred;
+        mSlot->mSize = 0;
+        mSlot->mFormat = format;
+    }
+}
+
+LogCapture::~LogCapture()
+{
+    if (mbSynchronous)
+    {
+        std::string message = SeverityPrefix(mSlot->mSeverity);
+        Logger::FormatDeferred(mSlot->mFormat, mSlot->mPayload, mSlot->mSize, message);
+        Logger::GetLogger().WriteSynchronous(message.c_str());
+    }
+    else if (mSlot)
+    {
+        Logger::GetLogger().Commit(mSlot, mPosition);
+    }
+}
+
+bool LogCapture::Reserve(size_t size)
+{
+    return mSlot && mSlot->mSize + size <= LogPayloadSize;
+}
+
+void LogCapture::AddSigned(int64_t value)
+{
+    if (Reserve(1 + sizeof(int64_t)))
+    {
+        mSlot->mPayload[mSlot->mSize] = LogArgument_Signed;
+        memcpy(&mSlot->mPayload[mSlot->mSize + 1], &value, sizeof(int64_t));
+        mSlot->mSize += 1 + sizeof(int64_t);
+    }
+}
+
+void LogCapture::AddUnsigned(uint64_t value)
+{
+    if (Reserve(1 + sizeof(uint64_t)))
+    {
+        mSlot->mPayload[mSlot->mSize] = LogArgument_Unsigned;
+        memcpy(&mSlot->mPayload[mSlot->mSize + 1], &value, sizeof(uint64_t));
+        mSlot->mSize += 1 + sizeof(uint64_t);
+    }
+}
+
+void LogCapture::AddDouble(double value)
+{
+    if (Reserve(1 + sizeof(double)))
+    {
+        mSlot->mPayload[mSlot->mSize] = LogArgument_Double;
+        memcpy(&mSlot->mPayload[mSlot->mSize + 1], &value, sizeof(double));
+        mSlot->mSize += 1 + sizeof(double);
+    }
+}
+
+void LogCapture::AddPointer(const void* value)
+{
+    if (Reserve(1 + sizeof(uint64_t)))
+    {
+        const uint64_t pointer = uint64_t(uintptr_t(value));
+        mSlot->mPayload[mSlot->mSize] = LogArgument_Pointer;
+        memcpy(&mSlot->mPayload[mSlot->mSize + 1], &pointer, sizeof(uint64_t));
+        mSlot->mSize += 1 + sizeof(uint64_t);
+    }
+}
+
+void LogCapture::AddString(const char* value, size_t length)
+{
+    const size_t header = 1 + sizeof(uint16_t);
+    if (!Reserve(header))
+    {
+        return;
+    }
+    const uint16_t copied = uint16_t(Min(length, LogPayloadSize - mSlot->mSize - header));
+    mSlot->mPayload[mSlot->mSize] = LogArgument_String;
+    memcpy(&mSlot->mPayload[mSlot->mSize + 1], &copied, sizeof(uint16_t));
+    memcpy(&mSlot->mPayload[mSlot->mSize + header], value, copied);
+    mSlot->mSize += uint16_t(header + copied);
+}
+
+void AddLogOutput(LogOutput output)
+{
+    Logger& logger = Logger::GetLogger();
+    std::lock_guard<std::mutex> lock(logger.mOutputMutex);
+    outputs.push_back(output);
+}
+
+int Log(const char* szFormat, ...)
+{
+    if (LogSeverity_Info < GEMONI_LOG_LEVEL)
+    {
+        return 0;
+    }
+    Logger& logger = Logger::GetLogger();
+    va_list ptr_arg;
+    va_start(ptr_arg, szFormat);
+
+    size_t position;
+    LogSlot* slot = logger.Claim(position);
+    if (!slot)
+    {
+        if (!logger.mbRunning)
+        {
+            static char buf[102400];
+            std::lock_guard<std::mutex> lock(logger.mMutex);
+            vsnprintf(buf, sizeof(buf), szFormat, ptr_arg);
+            logger.WriteSynchronous(buf);
+        }
+        va_end(ptr_arg);
+        return 0;
+    }
+
+    slot->mSeverity = LogSeverity_Info;
+    va_list copy_arg;
+    va_copy(copy_arg, ptr_arg);
+    const int length = vsnprintf((char*)slot->mPayload, LogPayloadSize, szFormat, ptr_arg);
+    if (length < 0)
+    {
+        slot->mKind = LogSlot_Text;
+        slot->mSize = 0;
+    }
+    else if (size_t(length) < LogPayloadSize)
+    {
+        slot->mKind = LogSlot_Text;
+        slot->mSize = uint16_t(length);
+    }
+    else
+    {
+        char* text = (char*)malloc(size_t(length) + 1);
+        if (text)
+        {
+            vsnprintf(text, size_t(length) + 1, szFormat, copy_arg);
+            slot->mKind = LogSlot_HeapText;
+            slot->mHeapText = text;
+        }
+        else
+        {
+            slot->mKind = LogSlot_Text;
+            slot->mSize = uint16_t(LogPayloadSize - 1);
+        }
+    }
+    va_end(copy_arg);
+    va_end(ptr_arg);
+    logger.Commit(slot, position);
+    return 0;
+}
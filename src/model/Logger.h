@@ -0,0 +1,152 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <string.h>
+#include <string>
+
+enum LogSeverity
+{
+    LogSeverity_Debug,
+    LogSeverity_Info,
+    LogSeverity_Warning,
+    LogSeverity_Error,
+};
+
+// Messages below this severity are compiled out: 0 debug, 1 info, 2 warning, 3 error.
+#ifndef GEMONI_LOG_LEVEL
+#define GEMONI_LOG_LEVEL 0
+#endif
+
+// Messages go through a lock free ring and are written to log.txt and the log outputs by a
+// background thread, in batches. Log() formats on the calling thread, LogDebug/LogInfo/LogWarning/
+// LogError only capture their arguments and the log thread formats them.
+// When the ring is full, messages are dropped and counted. Once the log thread is stopped (exit),
+// messages are formatted and written on the calling thread.
+
+// Waits for every message logged so far to be written.
+void FlushLog();
+uint64_t GetDroppedLogCount();
+
+struct LogSlot;
+
+// Deferred formatting. The format must outlive the message, use string literals. Strings are
+// copied, long ones are truncated to the ring slot size. '*' width and precision are not supported.
+class LogCapture
+{
+public:
+    LogCapture(LogSeverity severity, const char* format);
+    ~LogCapture();
+    LogCapture(const LogCapture&) = delete;
+    LogCapture& operator=(const LogCapture&) = delete;
+
+    void AddSigned(int64_t value);
+    void AddUnsigned(uint64_t value);
+    void AddDouble(double value);
+    void AddPointer(const void* value);
+    void AddString(const char* value, size_t length);
+
+private:
+    bool Reserve(size_t size);
+
+    LogSlot* mSlot;
+    size_t mPosition;
+    bool mbSynchronous; // log thread stopped, mSlot is not in the ring
+};
+
+inline void LogArgument(LogCapture& capture, int value) { capture.AddSigned(value); }
+inline void LogArgument(LogCapture& capture, long value) { capture.AddSigned(value); }
+inline void LogArgument(LogCapture& capture, long long value) { capture.AddSigned(value); }
+inline void LogArgument(LogCapture& capture, unsigned int value) { capture.AddUnsigned(value); }
+inline void LogArgument(LogCapture& capture, unsigned long value) { capture.AddUnsigned(value); }
+inline void LogArgument(LogCapture& capture, unsigned long long value) { capture.AddUnsigned(value); }
+inline void LogArgument(LogCapture& capture, double value) { capture.AddDouble(value); }
+inline void LogArgument(LogCapture& capture, const void* value) { capture.AddPointer(value); }
+inline void LogArgument(LogCapture& capture, const char* value)
+{
+    capture.AddString(value ? value : "(null)", value ? strlen(value) : 6);
+}
+inline void LogArgument(LogCapture& capture, const std::string& value)
+{
+    capture.AddString(value.c_str(), value.size());
+}
+
+inline void LogArguments(LogCapture&)
+{
+}
+
+template<typename T, typename... Args>
+void LogArguments(LogCapture& capture, const T& value, const Args&... args)
+{
+    LogArgument(capture, value);
+    LogArguments(capture, args...);
+}
+
+template<typename... Args>
+void LogDeferred(LogSeverity severity, const char* format, const Args&... args)
+{
+    LogCapture capture(severity, format);
+    LogArguments(capture, args...);
+}
+
+template<typename... Args>
+void LogDebug(const char* format, const Args&... args)
+{
+    if (LogSeverity_Debug >= GEMONI_LOG_LEVEL)
+    {
+        LogDeferred(LogSeverity_Debug, format, args...);
+    }
+}
+
+template<typename... Args>
+void LogInfo(const char* format, const Args&... args)
+{
+    if (LogSeverity_Info >= GEMONI_LOG_LEVEL)
+    {
+        LogDeferred(LogSeverity_Info, format, args...);
+    }
+}
+
+template<typename... Args>
+void LogWarning(const char* format, const Args&... args)
+{
+    if (LogSeverity_Warning >= GEMONI_LOG_LEVEL)
+    {
+        LogDeferred(LogSeverity_Warning, format, args...);
+    }
+}
+
+template<typename... Args>
+void LogError(const char* format, const Args&... args)
+{
+    if (LogSeverity_Error >= GEMONI_LOG_LEVEL)
+    {
+        LogDeferred(LogSeverity_Error, format, args...);
+    }
+}
@@ -0,0 +1,194 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include "MappedFile.h"
+
+#ifdef WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+#ifdef WIN32
+
+bool MappedFile::Open(const char* filename)
+{
+    Close();
+    HANDLE file = CreateFileA(filename, GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    mFile = file;
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || !size.QuadPart)
+    {
+        Close();
+        return false;
+    }
+    mMapping = CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL);
+    if (!mMapping)
+    {
+        Close();
+        return false;
+    }
+    mData = (uint8_t*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+    if (!mData)
+    {
+        Close();
+        return false;
+    }
+    mSize = size_t(size.QuadPart);
+    return true;
+}
+
+bool MappedFile::Create(const char* filename, size_t size)
+{
+    Close();
+    if (!size)
+    {
+        return false;
+    }
+    HANDLE file = CreateFileA(filename, GENERIC_READ | GENERIC_WRITE, FILE_SHARE_READ, NULL, CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE)
+    {
+        return false;
+    }
+    mFile = file;
+    const uint64_t size64 = uint64_t(size);
+    mMapping = CreateFileMappingA(file, NULL, PAGE_READWRITE, DWORD(size64 >> 32), DWORD(size64 & 0xFFFFFFFF), NULL);
+    if (!mMapping)
+    {
+        Close();
+        return false;
+    }
+    mData = (uint8_t*)MapViewOfFile(mMapping, FILE_MAP_WRITE, 0, 0, size);
+    if (!mData)
+    {
+        Close();
+        return false;
+    }
+    mSize = size;
+    mbWritable = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData)
+    {
+        UnmapViewOfFile(mData);
+    }
+    if (mMapping)
+    {
+        CloseHandle(mMapping);
+    }
+    if (mFile)
+    {
+        CloseHandle(mFile);
+    }
+    mData = nullptr;
+    mbWritable = false;
+    mMapping = nullptr;
+    mFile = nullptr;
+    mSize = 0;
+}
+
+#else
+
+bool MappedFile::Open(const char* filename)
+{
+    Close();
+    mFile = open(filename, O_RDONLY);
+    if (mFile < 0)
+    {
+        return false;
+    }
+    struct stat st;
+    if (fstat(mFile, &st) || !st.st_size)
+    {
+        Close();
+        return false;
+    }
+    void* data = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, mFile, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    mData = (uint8_t*)data;
+    mSize = size_t(st.st_size);
+    return true;
+}
+
+bool MappedFile::Create(const char* filename, size_t size)
+{
+    Close();
+    if (!size)
+    {
+        return false;
+    }
+    mFile = open(filename, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    if (mFile < 0)
+    {
+        return false;
+    }
+    if (ftruncate(mFile, off_t(size)))
+    {
+        Close();
+        return false;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, mFile, 0);
+    if (data == MAP_FAILED)
+    {
+        Close();
+        return false;
+    }
+    mData = (uint8_t*)data;
+    mSize = size;
+    mbWritable = true;
+    return true;
+}
+
+void MappedFile::Close()
+{
+    if (mData)
+    {
+        munmap(mData, mSize);
+    }
+    if (mFile >= 0)
+    {
+        close(mFile);
+    }
+    mData = nullptr;
+    mbWritable = false;
+    mFile = -1;
+    mSize = 0;
+}
+
+#endif
@@ -0,0 +1,61 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+
+// Memory mapping of a whole file, read only or, with Create, shared read write
+struct MappedFile
+{
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile()
+    {
+        Close();
+    }
+
+    bool Open(const char* filename);
+    // Creates or truncates filename to size bytes and maps it for writing.
+    bool Create(const char* filename, size_t size);
+    void Close();
+
+    const uint8_t* Data() const { return mData; }
+    uint8_t* WritableData() const { return mbWritable ? mData : nullptr; }
+    size_t Size() const { return mSize; }
+
+private:
+    uint8_t* mData{ nullptr };
+    bool mbWritable{ false };
+    size_t mSize{ 0 };
+#ifdef WIN32
+    void* mFile{ nullptr };
+    void* mMapping{ nullptr };
+#else
+    int mFile{ -1 };
+#endif
+};
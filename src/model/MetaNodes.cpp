@@ -24,14 +24,22 @@
 //
 
 #include <map>
-#include "rapidjson/document.h"
+#include <stdarg.h>
+#include <stdio.h>
+#include <string.h>
 #include "rapidjson/rapidjson.h"
-#include "rapidjson/writer.h"
+#include "rapidjson/reader.h"
+#include "rapidjson/error/en.h"
 
 #include "MetaNodes.h"
 #include "Utils.h"
 #include "Camera.h"
+#include "MetaNodesCache.h"
+#include "Trace.h"
 #include <algorithm>
+#include <unordered_map>
+#include <chrono>
+#include <iterator>
 #include <iostream>
 #include <fstream>
 
@@ -109,7 +117,167 @@ size_t GetParameterTypeSize(ConTypes paramType)
     return -1;
 }
 
+size_t GetParameterTypeAlignment(ConTypes paramType)
+{
+    switch (paramType)
+    {
+    case Con_FilenameRead:
+    case Con_FilenameWrite:
+    case Con_ForceEvaluate:
+        return 1;
+    case Con_Camera:
+        return alignof(Camera);
+    default:
+        return alignof(float);
+    }
+}
+
+void ComputeMetaNodeLayout(MetaNode& metaNode)
+{
+    // parameters are tightly packed in declaration order. Alignment is informative
+    // so parameter blocks allocated outside of a std::vector can honor it.
+    metaNode.mParametersLayout.resize(metaNode.mParams.size());
+    size_t offset = 0;
+    size_t alignment = 1;
+    for (size_t i = 0; i < metaNode.mParams.size(); i++)
+    {
+        const ConTypes paramType = metaNode.mParams[i].mType;
+        MetaParameterLayout& layout = metaNode.mParametersLayout[i];
+        layout.mOffset = uint32_t(offset);
+        layout.mSize = uint32_t(GetParameterTypeSize(paramType));
+        layout.mAlignment = uint32_t(GetParameterTypeAlignment(paramType));
+        offset += layout.mSize;
+        alignment = std::max(alignment, size_t(layout.mAlignment));
+    }
+    metaNode.mParametersSize = offset;
+    metaNode.mParametersAlignment = alignment;
+
+    // name and type lookups
+    metaNode.mParametersByName.resize(metaNode.mParams.size());
+    std::fill(std::begin(metaNode.mFirstParameterOfType), std::end(metaNode.mFirstParameterOfType), -1);
+    for (size_t i = 0; i < metaNode.mParams.size(); i++)
+    {
+        const MetaParameter& param = metaNode.mParams[i];
+        metaNode.mParametersByName[i] = { HashString(param.mName.c_str()), uint32_t(i) };
+        if (param.mType < Con_Any && metaNode.mFirstParameterOfType[param.mType] == -1)
+        {
+            metaNode.mFirstParameterOfType[param.mType] = int(i);
+        }
+    }
+    std::stable_sort(metaNode.mParametersByName.begin(),
+                     metaNode.mParametersByName.end(),
+                     [](const MetaParameterName& a, const MetaParameterName& b) { return a.mHash < b.mHash; });
+}
+
+// FNV-1a over the content. Strings and arrays are length prefixed so field boundaries matter.
+struct ContentHash
+{
+    uint64_t mHash{ 14695981039346656037ULL };
+
+    template<typename T> void Add(const T& value)
+    {
+        mHash = HashData64(&value, sizeof(T), mHash);
+    }
+    void Add(const std::string& str)
+    {
+        Add(uint32_t(str.size()));
+        mHash = HashData64(str.data(), str.size(), mHash);
+    }
+    void Add(const std::vector<unsigned char>& data)
+    {
+        Add(uint32_t(data.size()));
+        mHash = HashData64(data.data(), data.size(), mHash);
+    }
+    void Add(const std::vector<MetaCon>& cons)
+    {
+        Add(uint32_t(cons.size()));
+        for (auto& con : cons)
+        {
+            Add(con.mName);
+            Add(con.mType);
+        }
+    }
+};
+
+static uint64_t ComputeMetaParameterHash(const MetaParameter& param)
+{
+    ContentHash hash;
+    hash.Add(param.mName);
+    hash.Add(int(param.mType));
+    hash.Add(int(param.mControlType));
+    hash.Add(param.mRangeMinX);
+    hash.Add(param.mRangeMaxX);
+    hash.Add(param.mRangeMinY);
+    hash.Add(param.mRangeMaxY);
+    hash.Add(param.mSliderMinX);
+    hash.Add(param.mSliderMaxX);
+    hash.Add(uint8_t((param.mbRelative ? 1 : 0) | (param.mbQuadSelect ? 2 : 0) | (param.mbLoop ? 4 : 0) |
+                     (param.mbHidden ? 8 : 0)));
+    hash.Add(param.mEnumList);
+    hash.Add(param.mDefaultValue);
+    hash.Add(param.mDescription);
+    return hash.mHash;
+}
+
+void ComputeMetaNodeHash(MetaNode& metaNode)
+{
+    ContentHash hash;
+    hash.Add(metaNode.mName);
+    hash.Add(metaNode.mHeaderColor);
+    hash.Add(metaNode.mCategory);
+    hash.Add(metaNode.mDescription);
+    hash.Add(metaNode.mInputs);
+    hash.Add(metaNode.mOutputs);
+    hash.Add(metaNode.mWidth);
+    hash.Add(metaNode.mHeight);
+    hash.Add(uint8_t((metaNode.mbHasUI ? 1 : 0) | (metaNode.mbSaveTexture ? 2 : 0) |
+                     (metaNode.mbExperimental ? 4 : 0) | (metaNode.mbThumbnail ? 8 : 0)));
+    hash.Add(uint32_t(metaNode.mParams.size()));
+    for (auto& param : metaNode.mParams)
+    {
+        param.mHash = ComputeMetaParameterHash(param);
+        hash.Add(param.mHash);
+    }
+    metaNode.mHash = hash.mHash;
+}
+
+void DiffMetaNodes(const std::vector<MetaNode>& previous, const std::vector<MetaNode>& current, MetaNodesDiff& diff)
+{
+    diff.mAdded.clear();
+    diff.mRemoved.clear();
+    diff.mChanged.clear();
 
+    // last definition of a name wins, like gMetaNodesIndices
+    std::unordered_map<std::string, size_t> previousIndices;
+    previousIndices.reserve(previous.size());
+    for (size_t i = 0; i < previous.size(); i++)
+    {
+        previousIndices[previous[i].mName] = i;
+    }
+    std::vector<bool> matched(previous.size(), false);
+    for (size_t i = 0; i < current.size(); i++)
+    {
+        auto iter = previousIndices.find(current[i].mName);
+        if (iter == previousIndices.end())
+        {
+            diff.mAdded.push_back(i);
+            continue;
+        }
+        matched[iter->second] = true;
+        if (previous[iter->second].mHash != current[i].mHash)
+        {
+            diff.mChanged.push_back(std::make_pair(iter->second, i));
+        }
+    }
+    for (auto& previousIndex : previousIndices)
+    {
+        if (!matched[previousIndex.second])
+        {
+            diff.mRemoved.push_back(previousIndex.second);
+        }
+    }
+    std::sort(diff.mRemoved.begin(), diff.mRemoved.end());
+}
 
 size_t GetMetaNodeIndex(const std::string& metaNodeName)
 {
@@ -124,299 +292,613 @@ size_t GetMetaNodeIndex(const std::string& metaNodeName)
 
 
 
-std::vector<MetaNode> ReadMetaNodes(const char* filename)
+// SAX handler building MetaNodes while the file is parsed: no intermediate DOM.
+// Values are checked against the key and the current context, semantic checks are done
+// when objects are closed so member order in the file does not matter.
+struct MetaNodesReader : public rapidjson::BaseReaderHandler<rapidjson::UTF8<>, MetaNodesReader>
 {
-    // read it back
-    std::vector<MetaNode> serNodes;
+    enum Context
+    {
+        Context_Root,
+        Context_Document,
+        Context_Nodes,
+        Context_Node,
+        Context_Color,
+        Context_Inputs,
+        Context_Outputs,
+        Context_Connector,
+        Context_Parameters,
+        Context_Parameter,
+        Context_Skip,
+    };
 
-    std::ifstream t(filename);
-    if (!t.good())
+    // parameter members are gathered first, validated and converted at the end of the object
+    struct ParameterValues
     {
-        Log("%s - Unable to load file.\n", filename);
-        return serNodes;
+        std::string mName;
+        std::string mType;
+        std::string mControl;
+        std::string mEnum;
+        std::string mDefault;
+        std::string mDescription;
+        float mRange[4];
+        float mSliderMinX, mSliderMaxX;
+        bool mbLoop, mbHidden, mbRelative, mbQuadSelect;
+        uint32_t mPresent;
+    };
+
+    enum PresentMember
+    {
+        Present_Name = 1 << 0,
+        Present_Type = 1 << 1,
+        Present_RangeMinX = 1 << 2,
+        Present_RangeMaxX = 1 << 3,
+        Present_RangeMinY = 1 << 4,
+        Present_RangeMaxY = 1 << 5,
+        Present_Control = 1 << 6,
+        Present_SliderMinX = 1 << 7,
+        Present_SliderMaxX = 1 << 8,
+        Present_Enum = 1 << 9,
+        Present_Default = 1 << 10,
+        Present_Category = 1 << 11,
+        Present_Color = 1 << 12,
+        Present_Nodes = 1 << 13,
+    };
+
+    MetaNodesReader(const char* filename, const char* json, rapidjson::StringStream& stream, std::vector<MetaNode>& nodes)
+        : mFilename(filename), mJson(json), mStream(stream), mNodes(nodes)
+    {
+        mContexts.push_back(Context_Root);
+    }
+
+    // line and column of the current parsing position
+    void GetLocation(size_t offset, int& line, int& column) const
+    {
+        line = 1;
+        column = 1;
+        for (size_t i = 0; i < offset && mJson[i]; i++)
+        {
+            if (mJson[i] == '\n')
+            {
+                line++;
+                column = 1;
+            }
+            else
+            {
+                column++;
+            }
+        }
+    }
+
+    bool Error(const char* format, ...)
+    {
+        char message[1024];
+        va_list ptr_arg;
+        va_start(ptr_arg, format);
+        vsnprintf(message, sizeof(message), format, ptr_arg);
+        va_end(ptr_arg);
+        int line, column;
+        GetLocation(mStream.Tell(), line, column);
+        Log("%s (%s:%d:%d)\n", message, mFilename, line, column);
+        mbError = true;
+        return false;
     }
-    std::string str((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
 
+    bool WrongValue()
+    {
+        return Error("Unexpected value for %s in node %s definition", mKey.c_str(), mNode.mName.c_str());
+    }
+
+    Context Top() const
+    {
+        return mContexts.back();
+    }
 
-    rapidjson::Document doc;
-    doc.Parse(str.c_str());
-    if (doc.HasParseError())
+    bool StartObject()
     {
-        Log("Parsing error in %s\n", filename);
-        return serNodes;
+        switch (Top())
+        {
+        case Context_Root:
+            mContexts.push_back(Context_Document);
+            return true;
+        case Context_Nodes:
+            mNode = MetaNode();
+            mNode.mCategory = 0;
+            mNode.mHeight = 100;
+            mNode.mWidth = 100;
+            mNode.mbExperimental = false;
+            mNode.mbHasUI = false;
+            mNode.mbThumbnail = true;
+            mNode.mbSaveTexture = false;
+            mNodePresent = 0;
+            mColorComponentCount = 0;
+            mContexts.push_back(Context_Node);
+            return true;
+        case Context_Inputs:
+        case Context_Outputs:
+            mConnectorName.clear();
+            mConnectorType.clear();
+            mConnectorPresent = 0;
+            mContexts.push_back(Context_Connector);
+            return true;
+        case Context_Parameters:
+            mParameter = ParameterValues();
+            mParameter.mbLoop = true;
+            mParameter.mbHidden = false;
+            mParameter.mbRelative = false;
+            mParameter.mbQuadSelect = false;
+            mParameter.mPresent = 0;
+            mContexts.push_back(Context_Parameter);
+            return true;
+        default:
+            return Skip();
+        }
     }
 
-    rapidjson::Value& nodesValue = doc["nodes"];
-    for (rapidjson::SizeType i = 0; i < nodesValue.Size(); i++)
+    bool StartArray()
     {
-        MetaNode curNode;
-        rapidjson::Value& node = nodesValue[i];
-        if (!node.HasMember("name"))
+        const Context top = Top();
+        if (top == Context_Document && mKey == "nodes")
+        {
+            mDocumentPresent |= Present_Nodes;
+            mContexts.push_back(Context_Nodes);
+        }
+        else if (top == Context_Node && mKey == "color")
+        {
+            mNodePresent |= Present_Color;
+            mContexts.push_back(Context_Color);
+        }
+        else if (top == Context_Node && mKey == "inputs")
         {
-            // error
-            Log("Missing name in node %d definition (%s)\n", i, filename);
-            return serNodes;
+            mContexts.push_back(Context_Inputs);
         }
-        curNode.mName = node["name"].GetString();
-        if (!node.HasMember("category"))
+        else if (top == Context_Node && mKey == "outputs")
+        {
+            mContexts.push_back(Context_Outputs);
+        }
+        else if (top == Context_Node && mKey == "parameters")
+        {
+            mContexts.push_back(Context_Parameters);
+        }
+        else
         {
-            // error
-            Log("Missing category in node %s definition (%s)\n", curNode.mName.c_str(), filename);
-            return serNodes;
+            return Skip();
         }
-        curNode.mCategory = node["category"].GetInt();
+        return true;
+    }
 
-        if (node.HasMember("description"))
+    // unknown members and their content are ignored
+    bool Skip()
+    {
+        if (Top() != Context_Skip)
         {
-            curNode.mDescription = node["description"].GetString();
+            mContexts.push_back(Context_Skip);
+            mSkipDepth = 0;
         }
+        mSkipDepth++;
+        return true;
+    }
 
-        if (node.HasMember("height"))
-            curNode.mHeight = node["height"].GetInt();
-        else
-            curNode.mHeight = 100;
+    bool EndSkip()
+    {
+        if (!--mSkipDepth)
+        {
+            mContexts.pop_back();
+        }
+        return true;
+    }
 
-        if (node.HasMember("width"))
-            curNode.mWidth = node["width"].GetInt();
-        else
-            curNode.mWidth = 100;
+    bool EndObject(rapidjson::SizeType)
+    {
+        const Context top = Top();
+        if (top == Context_Skip)
+        {
+            return EndSkip();
+        }
+        mContexts.pop_back();
+        switch (top)
+        {
+        case Context_Node:
+            return EndNode();
+        case Context_Connector:
+            return EndConnector(Top() == Context_Inputs);
+        case Context_Parameter:
+            return EndParameter();
+        default:
+            return true;
+        }
+    }
 
-        if (node.HasMember("experimental"))
-            curNode.mbExperimental = node["experimental"].GetBool();
-        else
-            curNode.mbExperimental = false;
+    bool EndArray(rapidjson::SizeType)
+    {
+        if (Top() == Context_Skip)
+        {
+            return EndSkip();
+        }
+        mContexts.pop_back();
+        return true;
+    }
 
-        curNode.mbHasUI = false;
-        if (node.HasMember("hasUI"))
+    bool Key(const char* str, rapidjson::SizeType length, bool)
+    {
+        if (Top() != Context_Skip)
         {
-            curNode.mbHasUI = node["hasUI"].GetBool();
+            mKey.assign(str, length);
         }
+        return true;
+    }
 
-        curNode.mbThumbnail = true;
-        if (node.HasMember("thumbnail"))
+    bool EndNode()
+    {
+        if (mNode.mName.empty())
+        {
+            return Error("Missing name in node %d definition", int(mNodes.size()));
+        }
+        if (!(mNodePresent & Present_Category))
         {
-            curNode.mbThumbnail = node["thumbnail"].GetBool();
+            return Error("Missing category in node %s definition", mNode.mName.c_str());
         }
+        if (!(mNodePresent & Present_Color))
+        {
+            return Error("Missing color in node %s definition", mNode.mName.c_str());
+        }
+        if (mColorComponentCount != 4)
+        {
+            return Error("wrong color component count in node %s definition", mNode.mName.c_str());
+        }
+        mNode.mHeaderColor = ColorF32(mColor[0], mColor[1], mColor[2], mColor[3]);
+        ComputeMetaNodeLayout(mNode);
+        ComputeMetaNodeHash(mNode);
+        mNodes.emplace_back(std::move(mNode));
+        return true;
+    }
 
-        if (node.HasMember("saveTexture"))
+    bool EndConnector(bool input)
+    {
+        const char* connectorKind = input ? "inputs" : "outputs";
+        if ((mConnectorPresent & (Present_Name | Present_Type)) != (Present_Name | Present_Type))
         {
-            curNode.mbSaveTexture = node["saveTexture"].GetBool();
+            return Error("Missing name or type in %s for node %s definition", connectorKind, mNode.mName.c_str());
         }
-        else
+        MetaCon metaCon;
+        metaCon.mName = std::move(mConnectorName);
+        metaCon.mType = GetParameterType(mConnectorType.c_str());
+        if (metaCon.mType == Con_Any)
+        {
+            return Error("Wrong type for %s in %s for node %s definition",
+                         metaCon.mName.c_str(),
+                         connectorKind,
+                         mNode.mName.c_str());
+        }
+        (input ? mNode.mInputs : mNode.mOutputs).emplace_back(std::move(metaCon));
+        return true;
+    }
+
+    bool EndParameter()
+    {
+        ParameterValues& values = mParameter;
+        if ((values.mPresent & (Present_Name | Present_Type)) != (Present_Name | Present_Type))
+        {
+            return Error("Missing name or type in parameters for node %s definition", mNode.mName.c_str());
+        }
+        MetaParameter metaParam;
+        metaParam.mName = std::move(values.mName);
+        metaParam.mType = GetParameterType(values.mType.c_str());
+        metaParam.mControlType = Control_NumericEdit;
+        if (metaParam.mType == Con_Any)
         {
-            curNode.mbSaveTexture = false;
+            return Error("Wrong type for %s in parameters for node %s definition",
+                         metaParam.mName.c_str(),
+                         mNode.mName.c_str());
         }
 
-        if (!node.HasMember("color"))
+        const uint32_t allRanges = Present_RangeMinX | Present_RangeMaxX | Present_RangeMinY | Present_RangeMaxY;
+        if ((values.mPresent & allRanges) == allRanges)
         {
-            // error
-            Log("Missing color in node %s definition (%s)\n", curNode.mName.c_str(), filename);
-            return serNodes;
+            metaParam.mRangeMinX = values.mRange[0];
+            metaParam.mRangeMaxX = values.mRange[1];
+            metaParam.mRangeMinY = values.mRange[2];
+            metaParam.mRangeMaxY = values.mRange[3];
         }
-        rapidjson::Value& color = node["color"];
-        float c[4];
-        if (color.Size() != 4)
+        else
         {
-            // error
-            Log("wrong color component count in node %s definition (%s)\n", curNode.mName.c_str(), filename);
-            return serNodes;
+            metaParam.mRangeMinX = metaParam.mRangeMinY = metaParam.mRangeMaxX = metaParam.mRangeMaxY = 0.f;
         }
-        for (rapidjson::SizeType i = 0; i < color.Size(); i++)
+        metaParam.mDescription = std::move(values.mDescription);
+        if ((values.mPresent & Present_Control) && values.mControl == "Slider")
         {
-            c[i] = color[i].GetFloat();
+            metaParam.mControlType = Control_Slider;
+            metaParam.mSliderMinX = (values.mPresent & Present_SliderMinX) ? values.mSliderMinX : 0.f;
+            metaParam.mSliderMaxX = (values.mPresent & Present_SliderMaxX) ? values.mSliderMaxX : 1.f;
         }
-        curNode.mHeaderColor = ColorF32(c[0], c[1], c[2], c[3]);
-        // inputs/outputs
-        if (node.HasMember("inputs"))
+        metaParam.mbLoop = values.mbLoop;
+        metaParam.mbHidden = values.mbHidden;
+        metaParam.mbRelative = values.mbRelative;
+        metaParam.mbQuadSelect = values.mbQuadSelect;
+
+        if (values.mPresent & Present_Enum)
         {
-            rapidjson::Value& inputs = node["inputs"];
-            for (rapidjson::SizeType i = 0; i < inputs.Size(); i++)
+            if (metaParam.mType != Con_Enum)
             {
-                MetaCon metaNode;
-                if (!inputs[i].HasMember("name") || !inputs[i].HasMember("type"))
-                {
-                    // error
-                    Log("Missing name or type in inputs for node %s definition (%s)\n",
-                        curNode.mName.c_str(),
-                        filename);
-                    return serNodes;
-                }
+                return Error("Mismatch type for enumerator in parameter %s for node %s definition",
+                             metaParam.mName.c_str(),
+                             mNode.mName.c_str());
+            }
+            if (values.mEnum.empty())
+            {
+                return Error("Empty string for enumerator in parameter %s for node %s definition",
+                             metaParam.mName.c_str(),
+                             mNode.mName.c_str());
+            }
+            metaParam.mEnumList = std::move(values.mEnum);
+            if (metaParam.mEnumList.back() != '|')
+                metaParam.mEnumList += '|';
+        }
+        if (values.mPresent & Present_Default)
+        {
+            metaParam.mDefaultValue.resize(GetParameterTypeSize(metaParam.mType));
+            ParseStringToParameter(values.mDefault, metaParam.mType, metaParam.mDefaultValue.data());
+        }
+        mNode.mParams.emplace_back(std::move(metaParam));
+        return true;
+    }
 
-                metaNode.mName = inputs[i]["name"].GetString();
-                metaNode.mType = GetParameterType(inputs[i]["type"].GetString());
-                if (metaNode.mType == Con_Any)
-                {
-                    // error
-                    Log("Wrong type for %s in inputs for node %s definition (%s)\n",
-                        metaNode.mName.c_str(),
-                        curNode.mName.c_str(),
-                        filename);
-                    return serNodes;
-                }
-                curNode.mInputs.emplace_back(metaNode);
+    bool String(const char* str, rapidjson::SizeType length, bool)
+    {
+        switch (Top())
+        {
+        case Context_Skip:
+            return true;
+        case Context_Node:
+            if (mKey == "name")
+                mNode.mName.assign(str, length);
+            else if (mKey == "description")
+                mNode.mDescription.assign(str, length);
+            else if (IsKnownNodeMember())
+                return WrongValue();
+            return true;
+        case Context_Connector:
+            if (mKey == "name")
+            {
+                mConnectorName.assign(str, length);
+                mConnectorPresent |= Present_Name;
             }
+            else if (mKey == "type")
+            {
+                mConnectorType.assign(str, length);
+                mConnectorPresent |= Present_Type;
+            }
+            return true;
+        case Context_Parameter:
+            return ParameterString(str, length);
+        case Context_Color:
+            return WrongValue();
+        default:
+            return true;
         }
-        if (node.HasMember("outputs"))
+    }
+
+    bool ParameterString(const char* str, rapidjson::SizeType length)
+    {
+        static const struct
+        {
+            const char* mKey;
+            std::string ParameterValues::*mMember;
+            uint32_t mPresent;
+        } stringMembers[] = {
+            { "name", &ParameterValues::mName, Present_Name },
+            { "type", &ParameterValues::mType, Present_Type },
+            { "control", &ParameterValues::mControl, Present_Control },
+            { "enum", &ParameterValues::mEnum, Present_Enum },
+            { "default", &ParameterValues::mDefault, Present_Default },
+            { "description", &ParameterValues::mDescription, 0 },
+        };
+        for (auto& member : stringMembers)
         {
-            rapidjson::Value& outputs = node["outputs"];
-            for (rapidjson::SizeType i = 0; i < outputs.Size(); i++)
+            if (mKey == member.mKey)
             {
-                MetaCon metaNode;
-                if (!outputs[i].HasMember("name") || !outputs[i].HasMember("type"))
-                {
-                    // error
-                    Log("Missing name or type in outputs for node %s definition (%s)\n",
-                        curNode.mName.c_str(),
-                        filename);
-                    return serNodes;
-                }
-                metaNode.mName = outputs[i]["name"].GetString();
-                metaNode.mType = GetParameterType(outputs[i]["type"].GetString());
-                if (metaNode.mType == Con_Any)
-                {
-                    // error
-                    Log("Wrong type for %s in outputs for node %s definition (%s)\n",
-                        metaNode.mName.c_str(),
-                        curNode.mName.c_str(),
-                        filename);
-                    return serNodes;
-                }
-                curNode.mOutputs.emplace_back(metaNode);
+                (mParameter.*member.mMember).assign(str, length);
+                mParameter.mPresent |= member.mPresent;
+                return true;
             }
         }
-        // parameters
-        if (node.HasMember("parameters"))
+        if (IsKnownParameterMember())
+        {
+            return WrongValue();
+        }
+        return true;
+    }
+
+    bool Number(double value)
+    {
+        switch (Top())
         {
-            rapidjson::Value& params = node["parameters"];
-            for (rapidjson::SizeType i = 0; i < params.Size(); i++)
+        case Context_Color:
+            if (mColorComponentCount < 4)
             {
-                MetaParameter metaParam;
-                rapidjson::Value& param = params[i];
-                if (!param.HasMember("name") || !param.HasMember("type"))
-                {
-                    // error
-                    Log("Missing name or type in parameters for node %s definition (%s)\n",
-                        curNode.mName.c_str(),
-                        filename);
-                    return serNodes;
-                }
-                metaParam.mName = param["name"].GetString();
-                metaParam.mType = GetParameterType(param["type"].GetString());
-                metaParam.mControlType = Control_NumericEdit;
-                if (metaParam.mType == Con_Any)
+                mColor[mColorComponentCount] = float(value);
+            }
+            mColorComponentCount++;
+            return true;
+        case Context_Node:
+            if (mKey == "category")
+            {
+                mNode.mCategory = int(value);
+                mNodePresent |= Present_Category;
+            }
+            else if (mKey == "height")
+                mNode.mHeight = int(value);
+            else if (mKey == "width")
+                mNode.mWidth = int(value);
+            else if (IsKnownNodeMember())
+                return WrongValue();
+            return true;
+        case Context_Parameter:
+        {
+            static const char* rangeKeys[] = { "rangeMinX", "rangeMaxX", "rangeMinY", "rangeMaxY" };
+            for (int i = 0; i < 4; i++)
+            {
+                if (mKey == rangeKeys[i])
                 {
-                    // error
-                    Log("Wrong type for %s in parameters for node %s definition (%s)\n",
-                        metaParam.mName.c_str(),
-                        curNode.mName.c_str(),
-                        filename);
-                    return serNodes;
+                    mParameter.mRange[i] = float(value);
+                    mParameter.mPresent |= Present_RangeMinX << i;
+                    return true;
                 }
+            }
+            if (mKey == "sliderMinX")
+            {
+                mParameter.mSliderMinX = float(value);
+                mParameter.mPresent |= Present_SliderMinX;
+            }
+            else if (mKey == "sliderMaxX")
+            {
+                mParameter.mSliderMaxX = float(value);
+                mParameter.mPresent |= Present_SliderMaxX;
+            }
+            else if (IsKnownParameterMember())
+                return WrongValue();
+            return true;
+        }
+        default:
+            return true;
+        }
+    }
 
-                if (param.HasMember("rangeMinX") && param.HasMember("rangeMaxX") && param.HasMember("rangeMinY") &&
-                    param.HasMember("rangeMaxY"))
-                {
-                    metaParam.mRangeMinX = param["rangeMinX"].GetFloat();
-                    metaParam.mRangeMaxX = param["rangeMaxX"].GetFloat();
-                    metaParam.mRangeMinY = param["rangeMinY"].GetFloat();
-                    metaParam.mRangeMaxY = param["rangeMaxY"].GetFloat();
-                }
-                else
-                {
-                    metaParam.mRangeMinX = metaParam.mRangeMinY = metaParam.mRangeMaxX = metaParam.mRangeMaxY = 0.f;
-                }
-                if (param.HasMember("description"))
-                {
-                    metaParam.mDescription = param["description"].GetString();
-                }
-                if (param.HasMember("control"))
-                {
-                    const char* control = param["control"].GetString();
-                    if (!strcmp(control, "Slider"))
-                    {
-                        metaParam.mControlType = Control_Slider;
-                        metaParam.mSliderMinX = 0.f;
-                        metaParam.mSliderMaxX = 1.f;
-                        if (param.HasMember("sliderMinX"))
-                        {
-                            metaParam.mSliderMinX = param["sliderMinX"].GetFloat();
-                        }
-                        if (param.HasMember("sliderMaxX"))
-                        {
-                            metaParam.mSliderMaxX = param["sliderMaxX"].GetFloat();
-                        }
-                    }
-                }
+    bool Bool(bool value)
+    {
+        switch (Top())
+        {
+        case Context_Node:
+            if (mKey == "experimental")
+                mNode.mbExperimental = value;
+            else if (mKey == "hasUI")
+                mNode.mbHasUI = value;
+            else if (mKey == "thumbnail")
+                mNode.mbThumbnail = value;
+            else if (mKey == "saveTexture")
+                mNode.mbSaveTexture = value;
+            else if (IsKnownNodeMember())
+                return WrongValue();
+            return true;
+        case Context_Parameter:
+            if (mKey == "loop")
+                mParameter.mbLoop = value;
+            else if (mKey == "hidden")
+                mParameter.mbHidden = value;
+            else if (mKey == "relative")
+                mParameter.mbRelative = value;
+            else if (mKey == "quadSelect")
+                mParameter.mbQuadSelect = value;
+            else if (IsKnownParameterMember())
+                return WrongValue();
+            return true;
+        case Context_Color:
+            return WrongValue();
+        default:
+            return true;
+        }
+    }
 
-                if (param.HasMember("loop"))
-                {
-                    metaParam.mbLoop = param["loop"].GetBool();
-                }
-                else
-                {
-                    metaParam.mbLoop = true;
-                }
+    bool Int(int value) { return Number(double(value)); }
+    bool Uint(unsigned value) { return Number(double(value)); }
+    bool Int64(int64_t value) { return Number(double(value)); }
+    bool Uint64(uint64_t value) { return Number(double(value)); }
+    bool Double(double value) { return Number(value); }
+    bool Null() { return true; }
 
-                metaParam.mbHidden = false;
-                if (param.HasMember("hidden"))
-                {
-                    metaParam.mbHidden = param["hidden"].GetBool();
-                }
+    // a known member with a value of the wrong kind is an error, unknown members are ignored
+    bool IsKnownNodeMember() const
+    {
+        static const char* members[] = { "name", "category", "description", "height", "width",
+                                          "experimental", "hasUI", "thumbnail", "saveTexture" };
+        return std::find_if(std::begin(members), std::end(members), [&](const char* member) { return mKey == member; }) !=
+               std::end(members);
+    }
 
-                if (param.HasMember("relative"))
-                    metaParam.mbRelative = param["relative"].GetBool();
-                else
-                    metaParam.mbRelative = false;
-                if (param.HasMember("quadSelect"))
-                    metaParam.mbQuadSelect = param["quadSelect"].GetBool();
-                else
-                    metaParam.mbQuadSelect = false;
-                if (param.HasMember("enum"))
-                {
-                    if (metaParam.mType != Con_Enum)
-                    {
-                        // error
-                        Log("Mismatch type for enumerator in parameter %s for node %s definition (%s)\n",
-                            metaParam.mName.c_str(),
-                            curNode.mName.c_str(),
-                            filename);
-                        return serNodes;
-                    }
-                    std::string enumStr = param["enum"].GetString();
-                    if (enumStr.size())
-                    {
-                        metaParam.mEnumList = enumStr;
-                        if (metaParam.mEnumList.back() != '|')
-                            metaParam.mEnumList += '|';
-                    }
-                    else
-                    {
-                        // error
-                        Log("Empty string for enumerator in parameter %s for node %s definition (%s)\n",
-                            metaParam.mName.c_str(),
-                            curNode.mName.c_str(),
-                            filename);
-                        return serNodes;
-                    }
-                }
-                if (param.HasMember("default"))
-                {
-                    size_t paramSize = GetParameterTypeSize(metaParam.mType);
-                    metaParam.mDefaultValue.resize(paramSize);
-                    std::string defaultStr = param["default"].GetString();
-                    ParseStringToParameter(defaultStr, metaParam.mType, metaParam.mDefaultValue.data());
-                }
+    bool IsKnownParameterMember() const
+    {
+        static const char* members[] = { "name", "type", "rangeMinX", "rangeMaxX", "rangeMinY", "rangeMaxY",
+                                         "description", "control", "sliderMinX", "sliderMaxX", "loop",
+                                         "hidden", "relative", "quadSelect", "enum", "default" };
+        return std::find_if(std::begin(members), std::end(members), [&](const char* member) { return mKey == member; }) !=
+               std::end(members);
+    }
 
-                curNode.mParams.emplace_back(metaParam);
-            }
+    const char* mFilename;
+    const char* mJson;
+    rapidjson::StringStream& mStream;
+    std::vector<MetaNode>& mNodes;
+
+    std::vector<Context> mContexts;
+    std::string mKey;
+    int mSkipDepth{ 0 };
+    bool mbError{ false };
+    uint32_t mDocumentPresent{ 0 };
+
+    MetaNode mNode;
+    uint32_t mNodePresent{ 0 };
+    float mColor[4];
+    int mColorComponentCount{ 0 };
+
+    std::string mConnectorName;
+    std::string mConnectorType;
+    uint32_t mConnectorPresent{ 0 };
+
+    ParameterValues mParameter;
+};
+
+// returns false when the json has errors. Nodes read before the first error are kept.
+static bool ParseMetaNodes(const char* json, const char* filename, std::vector<MetaNode>& serNodes)
+{
+    rapidjson::StringStream stream(json);
+    MetaNodesReader handler(filename, json, stream, serNodes);
+    rapidjson::Reader reader;
+    rapidjson::ParseResult result = reader.Parse(stream, handler);
+    if (result.IsError())
+    {
+        if (!handler.mbError)
+        {
+            int line, column;
+            handler.GetLocation(result.Offset(), line, column);
+            Log("Parsing error in %s:%d:%d: %s\n", filename, line, column, rapidjson::GetParseError_En(result.Code()));
         }
+        return false;
+    }
+    if (!(handler.mDocumentPresent & MetaNodesReader::Present_Nodes))
+    {
+        Log("Missing nodes array in %s\n", filename);
+        return false;
+    }
+    return true;
+}
 
-        serNodes.emplace_back(curNode);
+static bool ReadMetaNodesFile(const char* filename, std::string& str)
+{
+    std::ifstream t(filename, std::ios::binary);
+    if (!t.good())
+    {
+        Log("%s - Unable to load file.\n", filename);
+        return false;
     }
+    str.assign((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
+    return true;
+}
+
+// returns false when the file is missing or has errors. Nodes read before the first error are kept.
+static bool ReadMetaNodes(const char* filename, std::vector<MetaNode>& serNodes)
+{
+    std::string str;
+    return ReadMetaNodesFile(filename, str) && ParseMetaNodes(str.c_str(), filename, serNodes);
+}
+
+std::vector<MetaNode> ReadMetaNodes(const char* filename)
+{
+    std::vector<MetaNode> serNodes;
+    ReadMetaNodes(filename, serNodes);
     return serNodes;
 }
 
-void LoadMetaNodes(const std::vector<std::string>& metaNodeFilenames)
+void LoadMetaNodes(const std::vector<std::string>& metaNodeFilenames, const char* cacheFilename)
 {
     static const uint32_t hcTransform = ColorU8(200, 200, 200, 255);
     static const uint32_t hcGenerator = ColorU8(150, 200, 150, 255);
@@ -426,33 +908,209 @@ void LoadMetaNodes(const std::vector<std::string>& metaNodeFilenames)
     static const uint32_t hcNoise = ColorU8(150, 250, 150, 255);
     static const uint32_t hcPaint = ColorU8(100, 250, 180, 255);
 
-    for (auto& filename : metaNodeFilenames)
+    TraceScope traceScope(TraceEvent_NodeLibraryLoad);
+    auto startTime = std::chrono::high_resolution_clock::now();
+    const size_t previousNodeCount = gMetaNodes.size();
+    PackedMetaNodes library;
+    const bool cacheHit = cacheFilename && LoadMetaNodesCache(cacheFilename, metaNodeFilenames, library);
+    if (cacheHit)
     {
-        std::vector<MetaNode> metaNodes = ReadMetaNodes(filename.c_str());
-        if (metaNodes.empty())
+        library.Unpack(gMetaNodes);
+    }
+    else
+    {
+        // files are read and parsed concurrently then appended in the order they were given
+        struct FileLoading
         {
-            //IMessageBox("Errors while parsing nodes definitions.\nCheck logs.", "Node Parsing Error!");
-            //exit(-1);
-            continue;
+            std::vector<MetaNode> mNodes;
+            bool mbValid;
+            float mReadTime;
+            float mParseTime;
+        };
+        std::vector<FileLoading> loadings(metaNodeFilenames.size());
+        ParallelFor(metaNodeFilenames.size(), 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; i++)
+            {
+                TraceScope fileTraceScope(TraceEvent_NodeFileParse, int32_t(i));
+                FileLoading& loading = loadings[i];
+                const char* filename = metaNodeFilenames[i].c_str();
+                auto readStart = std::chrono::high_resolution_clock::now();
+                std::string str;
+                loading.mbValid = ReadMetaNodesFile(filename, str);
+                auto parseStart = std::chrono::high_resolution_clock::now();
+                loading.mbValid = loading.mbValid && ParseMetaNodes(str.c_str(), filename, loading.mNodes);
+                auto parseEnd = std::chrono::high_resolution_clock::now();
+                loading.mReadTime = std::chrono::duration<float, std::milli>(parseStart - readStart).count();
+                loading.mParseTime = std::chrono::duration<float, std::milli>(parseEnd - parseStart).count();
+            }
+        });
+
+        auto mergeStart = std::chrono::high_resolution_clock::now();
+        bool valid = true;
+        for (size_t i = 0; i < loadings.size(); i++)
+        {
+            FileLoading& loading = loadings[i];
+            valid &= loading.mbValid;
+            Log("    %s: %d nodes, read %.2f ms, parse %.2f ms\n",
+                metaNodeFilenames[i].c_str(),
+                int(loading.mNodes.size()),
+                loading.mReadTime,
+                loading.mParseTime);
+            if (loading.mNodes.empty())
+            {
+                //IMessageBox("Errors while parsing nodes definitions.\nCheck logs.", "Node Parsing Error!");
+                //exit(-1);
+                continue;
+            }
+            gMetaNodes.insert(gMetaNodes.end(),
+                              std::make_move_iterator(loading.mNodes.begin()),
+                              std::make_move_iterator(loading.mNodes.end()));
+        }
+        float mergeTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - mergeStart).count();
+        Log("    merge: %.2f ms\n", mergeTime);
+
+        // a library with errors is not cached so the errors are reported at every start until fixed
+        if (cacheFilename && valid)
+        {
+            library.Build(gMetaNodes.data() + previousNodeCount, gMetaNodes.size() - previousNodeCount);
+            SaveMetaNodesCache(cacheFilename, metaNodeFilenames, library);
         }
-        gMetaNodes.insert(gMetaNodes.end(), metaNodes.begin(), metaNodes.end());
     }
 
+    InvalidatePackedMetaNodes();
 
     for (size_t i = 0; i < gMetaNodes.size(); i++)
     {
         gMetaNodesIndices[gMetaNodes[i].mName] = i;
     }
+
+    float loadingTime = std::chrono::duration<float, std::milli>(std::chrono::high_resolution_clock::now() - startTime).count();
+    Log("%d node definitions loaded from %d files in %.2f ms (%s)\n",
+        int(gMetaNodes.size() - previousNodeCount),
+        int(metaNodeFilenames.size()),
+        loadingTime,
+        cacheHit ? "binary cache" : "json");
+}
+
+ParameterMigration BuildParameterMigration(uint16_t nodeType, const MetaNode& previous, const MetaNode& current)
+{
+    ParameterMigration migration;
+    migration.mNodeType = nodeType;
+    migration.mSourceSize = previous.mParametersSize;
+
+    migration.mDefaults.resize(current.mParametersSize, 0);
+    for (size_t i = 0; i < current.mParams.size(); i++)
+    {
+        const MetaParameter& param = current.mParams[i];
+        if (!param.mDefaultValue.empty())
+        {
+            memcpy(migration.mDefaults.data() + current.mParametersLayout[i].mOffset,
+                   param.mDefaultValue.data(),
+                   param.mDefaultValue.size());
+        }
+    }
+
+    for (size_t i = 0; i < current.mParams.size(); i++)
+    {
+        const MetaParameter& param = current.mParams[i];
+        int previousIndex = -1;
+        for (size_t j = 0; j < previous.mParams.size(); j++)
+        {
+            if (previous.mParams[j].mName == param.mName)
+            {
+                previousIndex = int(j);
+                break;
+            }
+        }
+        if (previousIndex == -1 || previous.mParams[previousIndex].mType != param.mType)
+        {
+            continue;
+        }
+        const MetaParameterLayout& source = previous.mParametersLayout[previousIndex];
+        const MetaParameterLayout& destination = current.mParametersLayout[i];
+        if (!destination.mSize)
+        {
+            continue;
+        }
+        if (!migration.mCopies.empty())
+        {
+            ParameterMigration::Copy& last = migration.mCopies.back();
+            if (last.mSourceOffset + last.mSize == source.mOffset &&
+                last.mDestinationOffset + last.mSize == destination.mOffset)
+            {
+                last.mSize += destination.mSize;
+                continue;
+            }
+        }
+        migration.mCopies.push_back({ source.mOffset, destination.mOffset, destination.mSize });
+    }
+    return migration;
+}
+
+static std::vector<MetaNodesReloadCallback> reloadCallbacks;
+void AddMetaNodesReloadCallback(MetaNodesReloadCallback callback)
+{
+    reloadCallbacks.push_back(callback);
+}
+
+bool ReloadMetaNodes(const char* filename)
+{
+    TraceScope traceScope(TraceEvent_NodeLibraryReload, int32_t(gMetaNodes.size()));
+    std::vector<MetaNode> nodes;
+    if (!ReadMetaNodes(filename, nodes))
+    {
+        // keep the current definitions until the file is fixed
+        return false;
+    }
+
+    std::vector<ParameterMigration> migrations;
+    int addedCount = 0;
+    for (auto& node : nodes)
+    {
+        auto iter = gMetaNodesIndices.find(node.mName);
+        if (iter == gMetaNodesIndices.end())
+        {
+            gMetaNodesIndices[node.mName] = gMetaNodes.size();
+            gMetaNodes.emplace_back(std::move(node));
+            addedCount++;
+            continue;
+        }
+        MetaNode& metaNode = gMetaNodes[iter->second];
+        if (metaNode.mHash == node.mHash)
+        {
+            continue;
+        }
+        if (metaNode.mParametersSize != node.mParametersSize || metaNode.mParams.size() != node.mParams.size() ||
+            !std::equal(metaNode.mParams.begin(), metaNode.mParams.end(), node.mParams.begin(),
+                        [](const MetaParameter& a, const MetaParameter& b) {
+                            return a.mName == b.mName && a.mType == b.mType;
+                        }))
+        {
+            migrations.emplace_back(BuildParameterMigration(uint16_t(iter->second), metaNode, node));
+        }
+        metaNode = std::move(node);
+    }
+    InvalidatePackedMetaNodes();
+
+    Log("%s reloaded: %d nodes added, %d parameter layouts changed\n", filename, addedCount, int(migrations.size()));
+    for (auto callback : reloadCallbacks)
+    {
+        callback(migrations);
+    }
+    return true;
 }
 
 void LoadMetaNodes()
 {
     std::vector<std::string> metaNodeFilenames;
     //DiscoverFiles("json", "Nodes/", metaNodeFilenames);
-    LoadMetaNodes(metaNodeFilenames);
+    // no cache until the files are discovered again, it would only store an empty library
+    LoadMetaNodes(metaNodeFilenames, nullptr);
 }
 
 #if 0
+#include "rapidjson/document.h"
+#include "rapidjson/writer.h"
 void SaveMetaNodes(const char* filename)
 {
     // write lib to json -----------------------
@@ -553,7 +1211,49 @@ void SaveMetaNodes(const char* filename)
 #endif
 
 
-void ParseStringToParameter(const std::string& str, ConTypes parameterType, void* parameterPtr)
+static const char* ParseNumber(const char* first, const char* last, float& value)
+{
+    return ParseFloat(first, last, value);
+}
+
+static const char* ParseNumber(const char* first, const char* last, int& value)
+{
+    return ParseInt(first, last, value);
+}
+
+// Reads up to count comma separated components, spaces are allowed around commas.
+// Parsing stops at the first malformed component, the following ones are left unchanged.
+template<typename T> static void ParseComponents(const char* str, T* values, int count)
+{
+    const char* last = str + strlen(str);
+    for (int i = 0; i < count; i++)
+    {
+        while (str != last && (*str == ' ' || *str == '\t'))
+        {
+            str++;
+        }
+        if (i)
+        {
+            if (str == last || *str != ',')
+            {
+                return;
+            }
+            str++;
+            while (str != last && (*str == ' ' || *str == '\t'))
+            {
+                str++;
+            }
+        }
+        const char* next = ParseNumber(str, last, values[i]);
+        if (next == str)
+        {
+            return;
+        }
+        str = next;
+    }
+}
+
+void ParseStringToParameter(const char* str, ConTypes parameterType, void* parameterPtr)
 {
     float* pf = (float*)parameterPtr;
     int* pi = (int*)parameterPtr;
@@ -564,28 +1264,28 @@ void ParseStringToParameter(const std::string& str, ConTypes parameterType, void
     {
     case Con_Angle:
     case Con_Float:
-        sscanf(str.c_str(), "%f", pf);
+        ParseComponents(str, pf, 1);
         break;
     case Con_Angle2:
     case Con_Float2:
-        sscanf(str.c_str(), "%f,%f", &pf[0], &pf[1]);
+        ParseComponents(str, pf, 2);
         break;
     case Con_Angle3:
     case Con_Float3:
-        sscanf(str.c_str(), "%f,%f,%f", &pf[0], &pf[1], &pf[2]);
+        ParseComponents(str, pf, 3);
         break;
     case Con_Color4:
     case Con_Float4:
     case Con_Angle4:
-        sscanf(str.c_str(), "%f,%f,%f,%f", &pf[0], &pf[1], &pf[2], &pf[3]);
+        ParseComponents(str, pf, 4);
         break;
     case Con_Multiplexer:
     case Con_Enum:
     case Con_Int:
-        sscanf(str.c_str(), "%d", &pi[0]);
+        ParseComponents(str, pi, 1);
         break;
     case Con_Int2:
-        sscanf(str.c_str(), "%d,%d", &pi[0], &pi[1]);
+        ParseComponents(str, pi, 2);
         break;
     case Con_Ramp:
         iv2[0] = {0, 0};
@@ -597,8 +1297,14 @@ void ParseStringToParameter(const std::string& str, ConTypes parameterType, void
         break;
     case Con_FilenameWrite:
     case Con_FilenameRead:
-        strcpy((char*)parameterPtr, str.c_str());
+    {
+        // truncated to the parameter size
+        const size_t maxLength = GetParameterTypeSize(parameterType) - 1;
+        const size_t length = Min(strlen(str), maxLength);
+        memcpy(parameterPtr, str, length);
+        ((char*)parameterPtr)[length] = 0;
         break;
+    }
     case Con_Structure:
     case Con_ForceEvaluate:
         break;
@@ -607,7 +1313,9 @@ void ParseStringToParameter(const std::string& str, ConTypes parameterType, void
         cam->mUp = Vec4(0.f, 1.f, 0.f, 0.f);
         break;
     case Con_Bool:
-        pi[0] = (str == "true") ? 1 : 0;
+        pi[0] = !strcmp(str, "true") ? 1 : 0;
+        break;
+    default:
         break;
     }
     if (parameterType >= Con_Angle && parameterType <= Con_Angle4)
@@ -619,19 +1327,68 @@ void ParseStringToParameter(const std::string& str, ConTypes parameterType, void
     }
 }
 
+void ParseStringToParameter(const std::string& str, ConTypes parameterType, void* parameterPtr)
+{
+    ParseStringToParameter(str.c_str(), parameterType, parameterPtr);
+}
+
+void ParseStringsToParameters(const ParameterParseRequest* requests, size_t count)
+{
+    TraceScope traceScope(TraceEvent_ParameterParse, -1, int32_t(count));
+    ParallelFor(count, 1024, [requests](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            ParseStringToParameter(requests[i].mString, requests[i].mType, requests[i].mDestination);
+        }
+    });
+}
+
 int GetParameterIndex(uint32_t nodeType, const char* parameterName)
 {
     const MetaNode& currentMeta = gMetaNodes[nodeType];
-    int i = 0;
-    for (const MetaParameter& param : currentMeta.mParams)
+    const uint32_t hash = HashString(parameterName);
+    auto iter = std::lower_bound(currentMeta.mParametersByName.begin(),
+                                 currentMeta.mParametersByName.end(),
+                                 hash,
+                                 [](const MetaParameterName& entry, uint32_t value) { return entry.mHash < value; });
+    for (; iter != currentMeta.mParametersByName.end() && iter->mHash == hash; ++iter)
     {
-        if (!strcmp(param.mName.c_str(), parameterName))
-            return i;
-        i++;
+        // only reached on a hash hit, most likely a single compare
+        if (!strcmp(currentMeta.mParams[iter->mIndex].mName.c_str(), parameterName))
+            return int(iter->mIndex);
     }
     return -1;
 }
 
+static ParameterHandle MakeParameterHandle(uint32_t nodeType, int parameterIndex)
+{
+    ParameterHandle handle;
+    handle.mNodeType = uint16_t(nodeType);
+    if (parameterIndex < 0)
+    {
+        return handle;
+    }
+    const MetaNode& currentMeta = gMetaNodes[nodeType];
+    handle.mParameterIndex = uint16_t(parameterIndex);
+    handle.mOffset = currentMeta.mParametersLayout[parameterIndex].mOffset;
+    handle.mType = currentMeta.mParams[parameterIndex].mType;
+    return handle;
+}
+
+ParameterHandle GetParameterHandle(uint32_t nodeType, const char* parameterName)
+{
+    return MakeParameterHandle(nodeType, GetParameterIndex(nodeType, parameterName));
+}
+
+ParameterHandle GetParameterHandle(uint32_t nodeType, ConTypes parameterType)
+{
+    if (parameterType >= Con_Any)
+    {
+        return MakeParameterHandle(nodeType, -1);
+    }
+    return MakeParameterHandle(nodeType, gMetaNodes[nodeType].mFirstParameterOfType[parameterType]);
+}
+
 
 size_t GetCurveCountPerParameterType(ConTypes paramType)
 {
@@ -773,16 +1530,12 @@ uint32_t GetCurveParameterColor(ConTypes paramType, int suffixIndex)
 size_t GetParameterOffset(uint32_t type, uint32_t parameterIndex)
 {
     const MetaNode& currentMeta = gMetaNodes[type];
-    size_t ret = 0;
-    int i = 0;
-    for (const MetaParameter& param : currentMeta.mParams)
+    if (parameterIndex >= currentMeta.mParametersLayout.size())
     {
-        if (i == parameterIndex)
-            break;
-        ret += GetParameterTypeSize(param.mType);
-        i++;
+        // one past the last parameter is the end of the block
+        return currentMeta.mParametersSize;
     }
-    return ret;
+    return currentMeta.mParametersLayout[parameterIndex].mOffset;
 }
 
 
@@ -838,10 +1591,5 @@ CurveType GetCurveTypeForParameterType(ConTypes paramType)
 
 size_t ComputeNodeParametersSize(size_t nodeType)
 {
-    size_t res = 0;
-    for (auto& param : gMetaNodes[nodeType].mParams)
-    {
-        res += GetParameterTypeSize(param.mType);
-    }
-    return res;
+    return gMetaNodes[nodeType].mParametersSize;
 }
\ No newline at end of file
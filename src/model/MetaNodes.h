@@ -87,18 +87,21 @@ struct MetaCon
 struct MetaParameter
 {
     std::string mName;
-    ConTypes mType;
-    ControlTypes mControlType;
-    float mRangeMinX, mRangeMaxX;
-    float mRangeMinY, mRangeMaxY;
-    float mSliderMinX, mSliderMaxX;
-    bool mbRelative;
-    bool mbQuadSelect;
-    bool mbLoop;
-    bool mbHidden;
+    ConTypes mType{ Con_Float };
+    ControlTypes mControlType{ Control_NumericEdit };
+    float mRangeMinX{ 0.f }, mRangeMaxX{ 0.f };
+    float mRangeMinY{ 0.f }, mRangeMaxY{ 0.f };
+    float mSliderMinX{ 0.f }, mSliderMaxX{ 1.f };
+    bool mbRelative{ false };
+    bool mbQuadSelect{ false };
+    bool mbLoop{ false };
+    bool mbHidden{ false };
     std::string mEnumList;
     std::vector<unsigned char> mDefaultValue;
     std::string mDescription;
+    // content hash of every field above, see ComputeMetaNodeHash. Compare it directly for a fast
+    // change test, operator== compares fields and doesn't need the hash to be computed.
+    uint64_t mHash{ 0 };
     bool operator==(const MetaParameter& other) const
     {
         if (mName != other.mName)
@@ -123,6 +126,21 @@ struct MetaParameter
     }
 };
 
+// location of one parameter inside a node parameter block
+struct MetaParameterLayout
+{
+    uint32_t mOffset;
+    uint32_t mSize;
+    uint32_t mAlignment;
+};
+
+// entry of the per node parameter name index, sorted by hash
+struct MetaParameterName
+{
+    uint32_t mHash;
+    uint32_t mIndex;
+};
+
 struct MetaNode
 {
     std::string mName;
@@ -140,6 +158,18 @@ struct MetaNode
     bool mbSaveTexture;
     bool mbExperimental;
     bool mbThumbnail;
+
+    // parameter block layout, computed once when the node is read. One entry per mParams
+    std::vector<MetaParameterLayout> mParametersLayout;
+    size_t mParametersSize;
+    size_t mParametersAlignment;
+    std::vector<MetaParameterName> mParametersByName;
+    int mFirstParameterOfType[Con_Any];
+
+    // content hash of the definition, parameters included, see ComputeMetaNodeHash.
+    // Layout fields are derived from it.
+    uint64_t mHash{ 0 };
+
     bool operator==(const MetaNode& other) const
     {
         if (mName != other.mName)
@@ -166,14 +196,83 @@ struct MetaNode
 
 extern std::vector<MetaNode> gMetaNodes;
 
+// Changes between two versions of a library, nodes are matched by name.
+struct MetaNodesDiff
+{
+    std::vector<size_t> mAdded;                         // index in current
+    std::vector<size_t> mRemoved;                       // index in previous
+    std::vector<std::pair<size_t, size_t>> mChanged;    // previous, current
+};
+
+// A parameter resolved once by name or type. Cache it and reuse it for every access
+// to parameter blocks of the same node type.
+struct ParameterHandle
+{
+    static const uint16_t InvalidIndex = 0xFFFF;
+
+    uint16_t mNodeType{ 0 };
+    uint16_t mParameterIndex{ InvalidIndex };
+    uint32_t mOffset{ 0 };
+    ConTypes mType{ Con_Any };
+
+    bool IsValid() const { return mParameterIndex != InvalidIndex; }
+};
+
+// Precomputed conversion of parameter blocks from one definition of a node type to the next.
+// Parameters are matched by name and type: kept ones are copied, new ones take their default
+// value, removed ones are dropped.
+struct ParameterMigration
+{
+    struct Copy
+    {
+        uint32_t mSourceOffset;
+        uint32_t mDestinationOffset;
+        uint32_t mSize;
+    };
+
+    uint16_t mNodeType;
+    size_t mSourceSize;
+    std::vector<Copy> mCopies; // adjacent parameters are merged in a single copy
+    std::vector<uint8_t> mDefaults; // new block with default values
+};
+
+ParameterMigration BuildParameterMigration(uint16_t nodeType, const MetaNode& previous, const MetaNode& current);
+
+// Called after a reload with one migration per node type whose definition changed.
+// Owners of parameter blocks migrate them (see MigrateParameterBlocks) and resolve their ParameterHandle again.
+typedef void (*MetaNodesReloadCallback)(const std::vector<ParameterMigration>& migrations);
+void AddMetaNodesReloadCallback(MetaNodesReloadCallback callback);
+
 size_t GetMetaNodeIndex(const std::string& metaNodeName);
 void LoadMetaNodes();
+// cacheFilename: optional binary cache of the library, see MetaNodesCache.h
+void LoadMetaNodes(const std::vector<std::string>& metaNodeFilenames, const char* cacheFilename = nullptr);
+std::vector<MetaNode> ReadMetaNodes(const char* filename);
+// Reads a definition file again and rebuilds changed nodes in place. Node type indices are stable:
+// new nodes are appended, nodes no longer defined stay in the library.
+bool ReloadMetaNodes(const char* filename);
 size_t GetParameterTypeSize(ConTypes paramType);
+size_t GetParameterTypeAlignment(ConTypes paramType);
+void ComputeMetaNodeLayout(MetaNode& metaNode);
+void ComputeMetaNodeHash(MetaNode& metaNode);
+void DiffMetaNodes(const std::vector<MetaNode>& previous, const std::vector<MetaNode>& current, MetaNodesDiff& diff);
 CurveType GetCurveTypeForParameterType(ConTypes paramType);
 const char* GetParameterTypeName(ConTypes paramType);
 ConTypes GetParameterType(uint32_t nodeType, uint32_t parameterIndex);
 void ParseStringToParameter(const std::string& str, ConTypes parameterType, void* parameterPtr);
+void ParseStringToParameter(const char* str, ConTypes parameterType, void* parameterPtr);
+
+struct ParameterParseRequest
+{
+    const char* mString;
+    ConTypes mType;
+    void* mDestination;
+};
+// Parses a list of strings at once, large lists are split over the worker threads. Destinations must not overlap.
+void ParseStringsToParameters(const ParameterParseRequest* requests, size_t count);
 int GetParameterIndex(uint32_t nodeType, const char* parameterName);
+ParameterHandle GetParameterHandle(uint32_t nodeType, const char* parameterName);
+ParameterHandle GetParameterHandle(uint32_t nodeType, ConTypes parameterType);
 size_t GetParameterOffset(uint32_t type, uint32_t parameterIndex);
 ConTypes GetParameterType(uint32_t nodeType, uint32_t parameterIndex);
 size_t GetCurveCountPerParameterType(ConTypes paramType);
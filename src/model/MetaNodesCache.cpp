@@ -0,0 +1,267 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fstream>
+#include <iterator>
+#include <memory>
+#include "MetaNodesCache.h"
+#include "MappedFile.h"
+#include "Utils.h"
+
+static const uint32_t CacheMagic = 0x434E4D47; // 'GMNC'
+static const uint32_t CacheVersion = 3;
+
+// header, source files, source paths then the packed library image. Sections are 8 bytes aligned.
+struct CacheHeader
+{
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint32_t mSourceCount;
+    uint32_t mPathPoolSize;
+    uint64_t mSourcesOffset;
+    uint64_t mPathPoolOffset;
+    uint64_t mLibraryOffset;
+    uint64_t mLibrarySize;
+    uint64_t mLayoutSignature;
+};
+
+struct CacheSource
+{
+    uint64_t mModificationTime;
+    uint64_t mSize;
+    uint64_t mHash;
+    uint32_t mPath;
+    uint32_t mPadding;
+};
+
+struct SourceFileInfo
+{
+    uint64_t mModificationTime;
+    uint64_t mSize;
+};
+
+static bool GetSourceFileInfo(const std::string& filename, SourceFileInfo& info)
+{
+    struct stat st;
+    if (stat(filename.c_str(), &st))
+    {
+        return false;
+    }
+    info.mModificationTime = uint64_t(st.st_mtime);
+    info.mSize = uint64_t(st.st_size);
+    return true;
+}
+
+static bool HashSourceFile(const std::string& filename, uint64_t& hash)
+{
+    std::ifstream t(filename, std::ios::binary);
+    if (!t.good())
+    {
+        return false;
+    }
+    std::string str((std::istreambuf_iterator<char>(t)), std::istreambuf_iterator<char>());
+    hash = HashData64(str.data(), str.size());
+    return true;
+}
+
+// parameter offsets and packed structures are baked in the image, a build with other
+// type sizes (a Camera change...) must not use it
+static uint64_t ComputeLayoutSignature()
+{
+    std::vector<uint64_t> layout;
+    for (int type = 0; type < Con_Any; type++)
+    {
+        if (type != Con_Structure)
+        {
+            layout.push_back(GetParameterTypeSize(ConTypes(type)));
+            layout.push_back(GetParameterTypeAlignment(ConTypes(type)));
+        }
+    }
+    layout.push_back(sizeof(PackedMetaNode));
+    layout.push_back(sizeof(PackedMetaCon));
+    layout.push_back(sizeof(PackedMetaParameter));
+    return HashData64(layout.data(), layout.size() * sizeof(uint64_t));
+}
+
+static size_t Align8(size_t offset)
+{
+    return (offset + 7) & ~size_t(7);
+}
+
+template<typename T> static const T* GetSection(const MappedFile& file, uint64_t offset, uint64_t count)
+{
+    if (offset > file.Size() || count > (file.Size() - offset) / sizeof(T))
+    {
+        return nullptr;
+    }
+    return (const T*)(file.Data() + offset);
+}
+
+bool LoadMetaNodesCache(const char* cacheFilename,
+                        const std::vector<std::string>& sourceFilenames,
+                        PackedMetaNodes& library)
+{
+    auto file = std::make_shared<MappedFile>();
+    if (!file->Open(cacheFilename) || file->Size() < sizeof(CacheHeader))
+    {
+        return false;
+    }
+    const CacheHeader& header = *(const CacheHeader*)file->Data();
+    if (header.mMagic != CacheMagic || header.mVersion != CacheVersion ||
+        header.mLayoutSignature != ComputeLayoutSignature() || header.mSourceCount != sourceFilenames.size())
+    {
+        return false;
+    }
+    const CacheSource* sources = GetSection<CacheSource>(*file, header.mSourcesOffset, header.mSourceCount);
+    const char* pathPool = GetSection<char>(*file, header.mPathPoolOffset, header.mPathPoolSize);
+    const uint8_t* libraryData = GetSection<uint8_t>(*file, header.mLibraryOffset, header.mLibrarySize);
+    if (!sources || !pathPool || !libraryData || !header.mPathPoolSize || pathPool[header.mPathPoolSize - 1])
+    {
+        Log("Node library cache %s is corrupted.\n", cacheFilename);
+        return false;
+    }
+
+    // sources: same files, same order. mtime and size first, content hash when they differ
+    bool sourcesTouched = false;
+    for (size_t i = 0; i < sourceFilenames.size(); i++)
+    {
+        const CacheSource& source = sources[i];
+        if (source.mPath >= header.mPathPoolSize || sourceFilenames[i] != pathPool + source.mPath)
+        {
+            return false;
+        }
+        SourceFileInfo info;
+        if (!GetSourceFileInfo(sourceFilenames[i], info))
+        {
+            return false;
+        }
+        if (info.mModificationTime == source.mModificationTime && info.mSize == source.mSize)
+        {
+            continue;
+        }
+        uint64_t hash;
+        if (info.mSize != source.mSize || !HashSourceFile(sourceFilenames[i], hash) || hash != source.mHash)
+        {
+            return false;
+        }
+        sourcesTouched = true;
+    }
+
+    // the library is used in place, the mapping lives as long as the image is referenced
+    PackedMetaNodes cachedLibrary;
+    if (!cachedLibrary.Attach(libraryData, size_t(header.mLibrarySize), file))
+    {
+        Log("Node library cache %s is corrupted.\n", cacheFilename);
+        return false;
+    }
+
+    if (sourcesTouched)
+    {
+        // content is unchanged but timestamps moved (checkout, copy...). Refresh them so next start is fast again.
+        // The image is copied and the file unmapped first: a mapped file can't be replaced on every platform.
+        cachedLibrary.Detach();
+        file.reset();
+        if (!SaveMetaNodesCache(cacheFilename, sourceFilenames, cachedLibrary))
+        {
+            Log("Unable to refresh node library cache %s\n", cacheFilename);
+        }
+    }
+    library = cachedLibrary;
+    return true;
+}
+
+bool SaveMetaNodesCache(const char* cacheFilename,
+                        const std::vector<std::string>& sourceFilenames,
+                        const PackedMetaNodes& library)
+{
+    std::vector<char> pathPool;
+    std::vector<CacheSource> sources;
+    for (auto& filename : sourceFilenames)
+    {
+        CacheSource source;
+        SourceFileInfo info;
+        if (!GetSourceFileInfo(filename, info) || !HashSourceFile(filename, source.mHash))
+        {
+            return false;
+        }
+        source.mModificationTime = info.mModificationTime;
+        source.mSize = info.mSize;
+        source.mPath = uint32_t(pathPool.size());
+        source.mPadding = 0;
+        pathPool.insert(pathPool.end(), filename.begin(), filename.end());
+        pathPool.push_back(0);
+        sources.push_back(source);
+    }
+    if (pathPool.empty())
+    {
+        pathPool.push_back(0);
+    }
+
+    CacheHeader header;
+    memset(&header, 0, sizeof(CacheHeader));
+    header.mMagic = CacheMagic;
+    header.mVersion = CacheVersion;
+    header.mLayoutSignature = ComputeLayoutSignature();
+    header.mSourceCount = uint32_t(sources.size());
+    header.mPathPoolSize = uint32_t(pathPool.size());
+
+    std::vector<uint8_t> buffer(sizeof(CacheHeader));
+    header.mSourcesOffset = buffer.size();
+    buffer.insert(buffer.end(), (const uint8_t*)sources.data(), (const uint8_t*)(sources.data() + sources.size()));
+    header.mPathPoolOffset = buffer.size();
+    buffer.insert(buffer.end(), pathPool.begin(), pathPool.end());
+    buffer.resize(Align8(buffer.size()), 0);
+    header.mLibraryOffset = buffer.size();
+    header.mLibrarySize = library.Size();
+    buffer.insert(buffer.end(), library.Data(), library.Data() + library.Size());
+    memcpy(buffer.data(), &header, sizeof(CacheHeader));
+
+    // write aside and swap so a concurrent reader never maps a partial file
+    std::string tempFilename = std::string(cacheFilename) + ".tmp";
+    FILE* fp = fopen(tempFilename.c_str(), "wb");
+    if (!fp)
+    {
+        Log("Unable to write node library cache %s\n", tempFilename.c_str());
+        return false;
+    }
+    const bool written = fwrite(buffer.data(), 1, buffer.size(), fp) == buffer.size();
+    fclose(fp);
+    if (!written)
+    {
+        remove(tempFilename.c_str());
+        return false;
+    }
+    remove(cacheFilename);
+    if (rename(tempFilename.c_str(), cacheFilename))
+    {
+        remove(tempFilename.c_str());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,421 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <map>
+#include <string>
+#include "PackedMetaNodes.h"
+#include "MappedFile.h"
+
+static PackedMetaNodes gPackedMetaNodes;
+static bool gPackedMetaNodesValid = false;
+
+const PackedMetaNodes& GetPackedMetaNodes()
+{
+    if (!gPackedMetaNodesValid)
+    {
+        gPackedMetaNodes.Build(gMetaNodes);
+        gPackedMetaNodesValid = true;
+    }
+    return gPackedMetaNodes;
+}
+
+void InvalidatePackedMetaNodes()
+{
+    gPackedMetaNodes.Clear();
+    gPackedMetaNodesValid = false;
+}
+
+// image layout: header then 8 bytes aligned sections. Offsets are relative to the image start.
+struct PackedMetaNodesHeader
+{
+    uint32_t mNodeCount;
+    uint32_t mConCount;
+    uint32_t mParameterCount;
+    uint32_t mDefaultValuesSize;
+    uint32_t mStringPoolSize;
+    uint32_t mPadding;
+    uint64_t mNodesOffset;
+    uint64_t mConsOffset;
+    uint64_t mParametersOffset;
+    uint64_t mDefaultValuesOffset;
+    uint64_t mStringPoolOffset;
+};
+
+struct PackedStringPool
+{
+    uint32_t Add(const std::string& str)
+    {
+        auto iter = mOffsets.find(str);
+        if (iter != mOffsets.end())
+        {
+            return iter->second;
+        }
+        uint32_t offset = uint32_t(mPool.size());
+        mPool.insert(mPool.end(), str.begin(), str.end());
+        mPool.push_back(0);
+        mOffsets[str] = offset;
+        return offset;
+    }
+
+    std::map<std::string, uint32_t> mOffsets;
+    std::vector<char> mPool;
+};
+
+static size_t Align8(size_t offset)
+{
+    return (offset + 7) & ~size_t(7);
+}
+
+template<typename T> static void AppendSection(std::vector<uint8_t>& buffer, uint64_t& offset, const std::vector<T>& section)
+{
+    buffer.resize(Align8(buffer.size()), 0);
+    offset = buffer.size();
+    const uint8_t* data = (const uint8_t*)section.data();
+    buffer.insert(buffer.end(), data, data + section.size() * sizeof(T));
+}
+
+template<typename T> static bool GetSection(const uint8_t* data, size_t size, uint64_t offset, uint64_t count, Span<T>& span)
+{
+    if (offset > size || (offset & 7) || count > (size - offset) / sizeof(T))
+    {
+        return false;
+    }
+    span.mData = (const T*)(data + offset);
+    span.mCount = size_t(count);
+    return true;
+}
+
+PackedMetaNodes::PackedMetaNodes(const PackedMetaNodes& other)
+{
+    *this = other;
+}
+
+PackedMetaNodes& PackedMetaNodes::operator=(const PackedMetaNodes& other)
+{
+    if (this == &other)
+    {
+        return *this;
+    }
+    mStorage = other.mStorage;
+    mMapping = other.mMapping;
+    mData = other.mData;
+    mSize = other.mSize;
+    mNodes = other.mNodes;
+    mCons = other.mCons;
+    mParameters = other.mParameters;
+    mDefaultValues = other.mDefaultValues;
+    mStrings = other.mStrings;
+    Rebase();
+    return *this;
+}
+
+void PackedMetaNodes::Rebase()
+{
+    // a mapped image is shared, an owned one points to its own storage
+    if (!mMapping && !mStorage.empty())
+    {
+        Attach(mStorage.data(), mStorage.size());
+    }
+}
+
+void PackedMetaNodes::Detach()
+{
+    if (!mData || (!mMapping && !mStorage.empty()))
+    {
+        return;
+    }
+    std::vector<uint8_t> storage(mData, mData + mSize);
+    mMapping.reset();
+    mStorage.swap(storage);
+    Rebase();
+}
+
+void PackedMetaNodes::Clear()
+{
+    // assigning an empty image would keep the storage capacity
+    std::vector<uint8_t>().swap(mStorage);
+    mMapping.reset();
+    mData = nullptr;
+    mSize = 0;
+    mNodes = {};
+    mCons = {};
+    mParameters = {};
+    mDefaultValues = {};
+    mStrings = {};
+}
+
+void PackedMetaNodes::Build(const MetaNode* metaNodes, size_t count)
+{
+    PackedStringPool strings;
+    strings.Add("");
+
+    std::vector<PackedMetaNode> nodes;
+    std::vector<PackedMetaCon> cons;
+    std::vector<PackedMetaParameter> parameters;
+    std::vector<uint8_t> defaultValues;
+    nodes.reserve(count);
+    for (size_t index = 0; index < count; index++)
+    {
+        const MetaNode& metaNode = metaNodes[index];
+        PackedMetaNode node;
+        node.mName = strings.Add(metaNode.mName);
+        node.mDescription = strings.Add(metaNode.mDescription);
+        node.mHeaderColor = metaNode.mHeaderColor;
+        node.mCategory = metaNode.mCategory;
+        node.mWidth = metaNode.mWidth;
+        node.mHeight = metaNode.mHeight;
+        node.mFlags = (metaNode.mbHasUI ? PackedMetaNode_HasUI : 0) |
+                      (metaNode.mbSaveTexture ? PackedMetaNode_SaveTexture : 0) |
+                      (metaNode.mbExperimental ? PackedMetaNode_Experimental : 0) |
+                      (metaNode.mbThumbnail ? PackedMetaNode_Thumbnail : 0);
+
+        node.mFirstInput = uint32_t(cons.size());
+        node.mInputCount = uint32_t(metaNode.mInputs.size());
+        for (auto& input : metaNode.mInputs)
+        {
+            cons.push_back({ strings.Add(input.mName), input.mType });
+        }
+        node.mFirstOutput = uint32_t(cons.size());
+        node.mOutputCount = uint32_t(metaNode.mOutputs.size());
+        for (auto& output : metaNode.mOutputs)
+        {
+            cons.push_back({ strings.Add(output.mName), output.mType });
+        }
+
+        // same tight packing as ComputeMetaNodeLayout, checked again by Attach
+        node.mFirstParameter = uint32_t(parameters.size());
+        node.mParameterCount = uint32_t(metaNode.mParams.size());
+        size_t offset = 0;
+        for (size_t i = 0; i < metaNode.mParams.size(); i++)
+        {
+            const MetaParameter& metaParam = metaNode.mParams[i];
+            PackedMetaParameter parameter;
+            parameter.mName = strings.Add(metaParam.mName);
+            parameter.mDescription = strings.Add(metaParam.mDescription);
+            parameter.mEnumList = strings.Add(metaParam.mEnumList);
+            parameter.mType = metaParam.mType;
+            parameter.mControlType = metaParam.mControlType;
+            parameter.mRangeMinX = metaParam.mRangeMinX;
+            parameter.mRangeMaxX = metaParam.mRangeMaxX;
+            parameter.mRangeMinY = metaParam.mRangeMinY;
+            parameter.mRangeMaxY = metaParam.mRangeMaxY;
+            parameter.mSliderMinX = metaParam.mSliderMinX;
+            parameter.mSliderMaxX = metaParam.mSliderMaxX;
+            parameter.mFlags = (metaParam.mbRelative ? PackedMetaParameter_Relative : 0) |
+                               (metaParam.mbQuadSelect ? PackedMetaParameter_QuadSelect : 0) |
+                               (metaParam.mbLoop ? PackedMetaParameter_Loop : 0) |
+                               (metaParam.mbHidden ? PackedMetaParameter_Hidden : 0);
+            parameter.mDefaultValueOffset = uint32_t(defaultValues.size());
+            parameter.mDefaultValueSize = uint32_t(metaParam.mDefaultValue.size());
+            parameter.mOffset = uint32_t(offset);
+            offset += GetParameterTypeSize(metaParam.mType);
+            defaultValues.insert(defaultValues.end(), metaParam.mDefaultValue.begin(), metaParam.mDefaultValue.end());
+            parameters.push_back(parameter);
+        }
+        node.mParametersSize = uint32_t(offset);
+        nodes.push_back(node);
+    }
+
+    PackedMetaNodesHeader header;
+    memset(&header, 0, sizeof(PackedMetaNodesHeader));
+    header.mNodeCount = uint32_t(nodes.size());
+    header.mConCount = uint32_t(cons.size());
+    header.mParameterCount = uint32_t(parameters.size());
+    header.mDefaultValuesSize = uint32_t(defaultValues.size());
+    header.mStringPoolSize = uint32_t(strings.mPool.size());
+
+    std::vector<uint8_t> storage(sizeof(PackedMetaNodesHeader));
+    AppendSection(storage, header.mNodesOffset, nodes);
+    AppendSection(storage, header.mConsOffset, cons);
+    AppendSection(storage, header.mParametersOffset, parameters);
+    AppendSection(storage, header.mDefaultValuesOffset, defaultValues);
+    AppendSection(storage, header.mStringPoolOffset, strings.mPool);
+    storage.resize(Align8(storage.size()), 0);
+    memcpy(storage.data(), &header, sizeof(PackedMetaNodesHeader));
+
+    mMapping.reset();
+    mStorage.swap(storage);
+    Rebase();
+}
+
+// parameter types ComputeMetaNodeLayout can lay out
+static bool IsValidParameterType(int32_t type)
+{
+    return type >= 0 && type < Con_Any && type != Con_Structure;
+}
+
+bool PackedMetaNodes::Attach(const uint8_t* data, size_t size, std::shared_ptr<MappedFile> mapping)
+{
+    if (size < sizeof(PackedMetaNodesHeader) || (uintptr_t(data) & 7))
+    {
+        return false;
+    }
+    PackedMetaNodesHeader header;
+    memcpy(&header, data, sizeof(PackedMetaNodesHeader));
+
+    Span<PackedMetaNode> nodes;
+    Span<PackedMetaCon> cons;
+    Span<PackedMetaParameter> parameters;
+    Span<uint8_t> defaultValues;
+    Span<char> strings;
+    if (!GetSection(data, size, header.mNodesOffset, header.mNodeCount, nodes) ||
+        !GetSection(data, size, header.mConsOffset, header.mConCount, cons) ||
+        !GetSection(data, size, header.mParametersOffset, header.mParameterCount, parameters) ||
+        !GetSection(data, size, header.mDefaultValuesOffset, header.mDefaultValuesSize, defaultValues) ||
+        !GetSection(data, size, header.mStringPoolOffset, header.mStringPoolSize, strings) || strings.empty() ||
+        strings[strings.size() - 1])
+    {
+        return false;
+    }
+
+    // every reference and type is checked once here so accessors and Unpack can stay unchecked
+    const uint32_t poolSize = header.mStringPoolSize;
+    for (auto& con : cons)
+    {
+        if (con.mName >= poolSize || con.mType < 0 || con.mType >= Con_Any)
+        {
+            return false;
+        }
+    }
+    for (auto& parameter : parameters)
+    {
+        if (parameter.mName >= poolSize || parameter.mDescription >= poolSize || parameter.mEnumList >= poolSize ||
+            uint64_t(parameter.mDefaultValueOffset) + parameter.mDefaultValueSize > defaultValues.size() ||
+            !IsValidParameterType(parameter.mType) || parameter.mControlType < Control_NumericEdit ||
+            parameter.mControlType > Control_Slider)
+        {
+            return false;
+        }
+        // default values are copied in the parameter blocks
+        if (parameter.mDefaultValueSize &&
+            parameter.mDefaultValueSize != GetParameterTypeSize(ConTypes(parameter.mType)))
+        {
+            return false;
+        }
+    }
+
+    for (auto& node : nodes)
+    {
+        if (node.mName >= poolSize || node.mDescription >= poolSize ||
+            uint64_t(node.mFirstInput) + node.mInputCount > cons.size() ||
+            uint64_t(node.mFirstOutput) + node.mOutputCount > cons.size() ||
+            uint64_t(node.mFirstParameter) + node.mParameterCount > parameters.size())
+        {
+            return false;
+        }
+        // offsets were computed by the build that wrote the image, they must match this build layout
+        size_t offset = 0;
+        for (uint32_t i = 0; i < node.mParameterCount; i++)
+        {
+            const PackedMetaParameter& parameter = parameters[node.mFirstParameter + i];
+            if (parameter.mOffset != offset)
+            {
+                return false;
+            }
+            offset += GetParameterTypeSize(ConTypes(parameter.mType));
+        }
+        if (node.mParametersSize != offset)
+        {
+            return false;
+        }
+    }
+
+    if (mStorage.empty() || data != mStorage.data())
+    {
+        mStorage.clear();
+    }
+    mMapping = mapping;
+    mData = data;
+    mSize = size;
+    mNodes = nodes;
+    mCons = cons;
+    mParameters = parameters;
+    mDefaultValues = defaultValues;
+    mStrings = strings;
+    return true;
+}
+
+void PackedMetaNodes::Unpack(std::vector<MetaNode>& metaNodes) const
+{
+    const size_t firstNode = metaNodes.size();
+    metaNodes.resize(firstNode + mNodes.size());
+    for (size_t i = 0; i < mNodes.size(); i++)
+    {
+        const PackedMetaNode& node = mNodes[i];
+        MetaNode& metaNode = metaNodes[firstNode + i];
+        metaNode.mName = GetString(node.mName);
+        metaNode.mDescription = GetString(node.mDescription);
+        metaNode.mHeaderColor = node.mHeaderColor;
+        metaNode.mCategory = node.mCategory;
+        metaNode.mWidth = node.mWidth;
+        metaNode.mHeight = node.mHeight;
+        metaNode.mbHasUI = (node.mFlags & PackedMetaNode_HasUI) != 0;
+        metaNode.mbSaveTexture = (node.mFlags & PackedMetaNode_SaveTexture) != 0;
+        metaNode.mbExperimental = (node.mFlags & PackedMetaNode_Experimental) != 0;
+        metaNode.mbThumbnail = (node.mFlags & PackedMetaNode_Thumbnail) != 0;
+
+        Span<PackedMetaCon> inputs = GetInputs(node);
+        metaNode.mInputs.resize(inputs.size());
+        for (size_t j = 0; j < inputs.size(); j++)
+        {
+            metaNode.mInputs[j].mName = GetString(inputs[j].mName);
+            metaNode.mInputs[j].mType = inputs[j].mType;
+        }
+        Span<PackedMetaCon> outputs = GetOutputs(node);
+        metaNode.mOutputs.resize(outputs.size());
+        for (size_t j = 0; j < outputs.size(); j++)
+        {
+            metaNode.mOutputs[j].mName = GetString(outputs[j].mName);
+            metaNode.mOutputs[j].mType = outputs[j].mType;
+        }
+        Span<PackedMetaParameter> parameters = GetParameters(node);
+        metaNode.mParams.resize(parameters.size());
+        for (size_t j = 0; j < parameters.size(); j++)
+        {
+            const PackedMetaParameter& parameter = parameters[j];
+            MetaParameter& metaParam = metaNode.mParams[j];
+            metaParam.mName = GetString(parameter.mName);
+            metaParam.mDescription = GetString(parameter.mDescription);
+            metaParam.mEnumList = GetString(parameter.mEnumList);
+            metaParam.mType = ConTypes(parameter.mType);
+            metaParam.mControlType = ControlTypes(parameter.mControlType);
+            metaParam.mRangeMinX = parameter.mRangeMinX;
+            metaParam.mRangeMaxX = parameter.mRangeMaxX;
+            metaParam.mRangeMinY = parameter.mRangeMinY;
+            metaParam.mRangeMaxY = parameter.mRangeMaxY;
+            metaParam.mSliderMinX = parameter.mSliderMinX;
+            metaParam.mSliderMaxX = parameter.mSliderMaxX;
+            metaParam.mbRelative = (parameter.mFlags & PackedMetaParameter_Relative) != 0;
+            metaParam.mbQuadSelect = (parameter.mFlags & PackedMetaParameter_QuadSelect) != 0;
+            metaParam.mbLoop = (parameter.mFlags & PackedMetaParameter_Loop) != 0;
+            metaParam.mbHidden = (parameter.mFlags & PackedMetaParameter_Hidden) != 0;
+            Span<uint8_t> defaultValue = GetDefaultValue(parameter);
+            metaParam.mDefaultValue.assign(defaultValue.begin(), defaultValue.end());
+        }
+        ComputeMetaNodeLayout(metaNode);
+        ComputeMetaNodeHash(metaNode);
+    }
+}
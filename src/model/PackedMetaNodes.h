@@ -0,0 +1,169 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <vector>
+#include <memory>
+#include "MetaNodes.h"
+
+struct MappedFile;
+
+template<typename T> struct Span
+{
+    const T* mData{ nullptr };
+    size_t mCount{ 0 };
+
+    const T* begin() const { return mData; }
+    const T* end() const { return mData + mCount; }
+    size_t size() const { return mCount; }
+    bool empty() const { return !mCount; }
+    const T& operator[](size_t index) const { return mData[index]; }
+};
+
+enum PackedMetaNodeFlags
+{
+    PackedMetaNode_HasUI = 1 << 0,
+    PackedMetaNode_SaveTexture = 1 << 1,
+    PackedMetaNode_Experimental = 1 << 2,
+    PackedMetaNode_Thumbnail = 1 << 3,
+};
+
+enum PackedMetaParameterFlags
+{
+    PackedMetaParameter_Relative = 1 << 0,
+    PackedMetaParameter_QuadSelect = 1 << 1,
+    PackedMetaParameter_Loop = 1 << 2,
+    PackedMetaParameter_Hidden = 1 << 3,
+};
+
+// Strings are offsets in the library string pool, use PackedMetaNodes::GetString
+struct PackedMetaCon
+{
+    uint32_t mName;
+    int32_t mType;
+};
+
+struct PackedMetaParameter
+{
+    uint32_t mName;
+    uint32_t mDescription;
+    uint32_t mEnumList;
+    int32_t mType;
+    int32_t mControlType;
+    float mRangeMinX, mRangeMaxX;
+    float mRangeMinY, mRangeMaxY;
+    float mSliderMinX, mSliderMaxX;
+    uint32_t mFlags;
+    uint32_t mDefaultValueOffset;
+    uint32_t mDefaultValueSize;
+    uint32_t mOffset; // in the parameter block
+};
+
+struct PackedMetaNode
+{
+    uint32_t mName;
+    uint32_t mDescription;
+    uint32_t mHeaderColor;
+    int32_t mCategory;
+    int32_t mWidth;
+    int32_t mHeight;
+    uint32_t mFirstInput;
+    uint32_t mInputCount;
+    uint32_t mFirstOutput;
+    uint32_t mOutputCount;
+    uint32_t mFirstParameter;
+    uint32_t mParameterCount;
+    uint32_t mParametersSize;
+    uint32_t mFlags;
+};
+
+// Read only, flat image of a node library: every node, connector, parameter and default value of
+// the library lives in one contiguous array per kind, all strings in a single deduplicated pool.
+// The image is one relocatable block: copying it is a memcpy and it can be used in place
+// from a memory mapped file (see MetaNodesCache.h).
+struct PackedMetaNodes
+{
+    PackedMetaNodes() = default;
+    PackedMetaNodes(const PackedMetaNodes& other);
+    PackedMetaNodes& operator=(const PackedMetaNodes& other);
+
+    void Build(const MetaNode* metaNodes, size_t count);
+    void Build(const std::vector<MetaNode>& metaNodes) { Build(metaNodes.data(), metaNodes.size()); }
+    // Uses an existing image without copying it. mapping, if any, is kept alive by this object,
+    // otherwise data must outlive it.
+    bool Attach(const uint8_t* data, size_t size, std::shared_ptr<MappedFile> mapping = nullptr);
+    // Copies an attached image to owned storage, releasing the mapping.
+    void Detach();
+    // Appends the nodes to metaNodes.
+    void Unpack(std::vector<MetaNode>& metaNodes) const;
+    void Clear();
+
+    const uint8_t* Data() const { return mData; }
+    size_t Size() const { return mSize; }
+
+    Span<PackedMetaNode> GetNodes() const { return mNodes; }
+    Span<PackedMetaCon> GetInputs(const PackedMetaNode& node) const
+    {
+        return { mCons.mData + node.mFirstInput, node.mInputCount };
+    }
+    Span<PackedMetaCon> GetOutputs(const PackedMetaNode& node) const
+    {
+        return { mCons.mData + node.mFirstOutput, node.mOutputCount };
+    }
+    Span<PackedMetaParameter> GetParameters(const PackedMetaNode& node) const
+    {
+        return { mParameters.mData + node.mFirstParameter, node.mParameterCount };
+    }
+    Span<uint8_t> GetDefaultValue(const PackedMetaParameter& parameter) const
+    {
+        return { mDefaultValues.mData + parameter.mDefaultValueOffset, parameter.mDefaultValueSize };
+    }
+    const char* GetString(uint32_t offset) const
+    {
+        return mStrings.mData + offset;
+    }
+
+private:
+    void Rebase();
+
+    std::vector<uint8_t> mStorage;
+    std::shared_ptr<MappedFile> mMapping;
+    const uint8_t* mData{ nullptr };
+    size_t mSize{ 0 };
+
+    Span<PackedMetaNode> mNodes;
+    Span<PackedMetaCon> mCons;
+    Span<PackedMetaParameter> mParameters;
+    Span<uint8_t> mDefaultValues;
+    Span<char> mStrings;
+};
+
+// Packed view of gMetaNodes, built on first use after gMetaNodes changed.
+const PackedMetaNodes& GetPackedMetaNodes();
+// Releases the packed view, called by LoadMetaNodes and ReloadMetaNodes.
+void InvalidatePackedMetaNodes();
@@ -28,34 +28,29 @@
 #include "ParameterBlock.h"
 #include "Camera.h"
 #include "Utils.h"
+#include "Trace.h"
 
 
 ParameterBlock& ParameterBlock::InitDefault()
 {
-    const MetaNode* metaNodes = gMetaNodes.data();
-    const MetaNode& currentMeta = metaNodes[mNodeType];
-    const size_t paramsSize = ComputeNodeParametersSize(mNodeType);
-    mDump.resize(paramsSize, 0);
+    const MetaNode& currentMeta = gMetaNodes[mNodeType];
+    mDump.resize(currentMeta.mParametersSize, 0);
     unsigned char* paramBuffer = mDump.data();
-    int i = 0;
-    for (const MetaParameter& param : currentMeta.mParams)
+    for (size_t i = 0; i < currentMeta.mParams.size(); i++)
     {
+        const MetaParameter& param = currentMeta.mParams[i];
         if (!param.mDefaultValue.empty())
         {
-            memcpy(paramBuffer, param.mDefaultValue.data(), param.mDefaultValue.size());
+            memcpy(paramBuffer + currentMeta.mParametersLayout[i].mOffset, param.mDefaultValue.data(), param.mDefaultValue.size());
         }
-
-        paramBuffer += GetParameterTypeSize(param.mType);
     }
     return *this;
 }
 
 float ParameterBlock::GetParameterComponentValue(int parameterIndex, int componentIndex) const
 {
-    size_t paramOffset = GetParameterOffset(uint32_t(mNodeType), parameterIndex);
-    const unsigned char* ptr = &mDump.data()[paramOffset];
-    const MetaNode* metaNodes = gMetaNodes.data();
-    const MetaNode& currentMeta = metaNodes[mNodeType];
+    const MetaNode& currentMeta = gMetaNodes[mNodeType];
+    const unsigned char* ptr = &mDump.data()[currentMeta.mParametersLayout[parameterIndex].mOffset];
     switch (currentMeta.mParams[parameterIndex].mType)
     {
     case Con_Angle:
@@ -94,57 +89,76 @@ float ParameterBlock::GetParameterComponentValue(int parameterIndex, int compone
     }
 }
 
-template<typename type> type ParameterBlock::GetParameter(const char* parameterName, type defaultValue, ConTypes parameterType) const
+template<typename type> type ParameterBlock::GetParameter(const ParameterHandle& handle, type defaultValue, ConTypes parameterType) const
 {
-    const MetaNode& currentMeta = gMetaNodes[mNodeType];
-    const unsigned char* paramBuffer = mDump.data();
-    for (const MetaParameter& param : currentMeta.mParams)
+    if (!handle.IsValid() || handle.mType != parameterType)
     {
-        if (param.mType == parameterType)
-        {
-            if (parameterName == nullptr || (!strcmp(param.mName.c_str(), parameterName)))
-            {
-                return *(type*)paramBuffer;
-            }
-        }
-        paramBuffer += GetParameterTypeSize(param.mType);
+        return defaultValue;
     }
-    return defaultValue;
+    assert(handle.mNodeType == mNodeType);
+    return *(type*)&mDump[handle.mOffset];
 }
 
-template<typename type> type* ParameterBlock::GetParameterPtr(const char* parameterName, type* defaultValue, ConTypes parameterType) const
+template<typename type> type* ParameterBlock::GetParameterPtr(const ParameterHandle& handle, type* defaultValue, ConTypes parameterType) const
 {
-    const MetaNode& currentMeta = gMetaNodes[mNodeType];
-    const unsigned char* paramBuffer = mDump.data();
-    for (const MetaParameter& param : currentMeta.mParams)
+    if (!handle.IsValid() || handle.mType != parameterType)
     {
-        if (param.mType == parameterType)
-        {
-            if (parameterName == nullptr || (!strcmp(param.mName.c_str(), parameterName)))
-            {
-                return (type*)paramBuffer;
-            }
-        }
-        paramBuffer += GetParameterTypeSize(param.mType);
+        return defaultValue;
     }
-    return defaultValue;
+    assert(handle.mNodeType == mNodeType);
+    return (type*)&mDump[handle.mOffset];
 }
 
 int ParameterBlock::GetIntParameter(const char* parameterName, int defaultValue) const
 {
-    return GetParameter(parameterName, defaultValue, Con_Int);
+    // without a name, the first Con_Int parameter is used
+    const ParameterHandle handle = parameterName ? GetParameterHandle(mNodeType, parameterName)
+                                                 : GetParameterHandle(mNodeType, Con_Int);
+    return GetParameter(handle, defaultValue, Con_Int);
+}
+
+int ParameterBlock::GetIntParameter(const ParameterHandle& handle, int defaultValue) const
+{
+    return GetParameter(handle, defaultValue, Con_Int);
 }
 
 Camera* ParameterBlock::GetCamera() const
 {
-    return GetParameterPtr<Camera>(nullptr, nullptr, Con_Camera);
+    return GetParameterPtr<Camera>(GetParameterHandle(mNodeType, Con_Camera), nullptr, Con_Camera);
 }
 
 void* ParameterBlock::Data(size_t parameterIndex)
 {
-    assert(parameterIndex< gMetaNodes[mNodeType].mParams.size());
-    size_t parameterOffset = GetParameterOffset(mNodeType, parameterIndex);
+    const MetaNode& currentMeta = gMetaNodes[mNodeType];
+    assert(parameterIndex < currentMeta.mParametersLayout.size());
     uint8_t* data = (uint8_t*)Data();
-    data += parameterOffset;
+    data += currentMeta.mParametersLayout[parameterIndex].mOffset;
     return data;
-}
\ No newline at end of file
+}
+
+void ParameterBlock::Migrate(const ParameterMigration& migration)
+{
+    assert(migration.mNodeType == mNodeType);
+    std::vector<unsigned char> dump(migration.mDefaults);
+    // a block not matching the previous layout can't be trusted, it gets default values only
+    if (mDump.size() == migration.mSourceSize)
+    {
+        for (auto& copy : migration.mCopies)
+        {
+            memcpy(dump.data() + copy.mDestinationOffset, mDump.data() + copy.mSourceOffset, copy.mSize);
+        }
+    }
+    mDump.swap(dump);
+}
+
+void MigrateParameterBlocks(const ParameterMigration& migration, ParameterBlock* blocks, size_t count)
+{
+    TraceScope traceScope(TraceEvent_ParameterMigration, int32_t(migration.mNodeType));
+    for (size_t i = 0; i < count; i++)
+    {
+        if (blocks[i].GetNodeType() == migration.mNodeType)
+        {
+            blocks[i].Migrate(migration);
+        }
+    }
+}
@@ -25,6 +25,7 @@
 
 #pragma once
 
+#include <assert.h>
 #include <vector>
 #include <string>
 #include "MetaNodes.h"
@@ -41,21 +42,42 @@ struct ParameterBlock
     }
     
     operator const std::vector<uint8_t>&() const { return mDump; }
+    uint16_t GetNodeType() const { return mNodeType; }
 
     ParameterBlock& InitDefault();
     float GetParameterComponentValue(int parameterIndex, int componentIndex) const;
     Camera* GetCamera() const;
     int GetIntParameter(const char* parameterName, int defaultValue) const;
+    int GetIntParameter(const ParameterHandle& handle, int defaultValue) const;
+    // block must be of migration.mNodeType, see ReloadMetaNodes
+    void Migrate(const ParameterMigration& migration);
     void *Data(size_t parameterInde);
     void* Data() { return mDump.data(); }
     const void* Data() const { return mDump.data(); }
 
+    // Typed access for nodes known at build time, Param being one of the layouts
+    // generated in NodeLayouts.h, for example Get<NodeLayouts::Blur::Strength>().
+    // Compiles to a load at a constant offset. Plugin defined nodes use the dynamic path.
+    template<typename Param> typename Param::Type& Get()
+    {
+        assert(gMetaNodes[mNodeType].mName == Param::Node::NodeName());
+        assert(gMetaNodes[mNodeType].mParametersLayout[Param::Index].mOffset == Param::Offset);
+        return *reinterpret_cast<typename Param::Type*>(mDump.data() + Param::Offset);
+    }
+    template<typename Param> const typename Param::Type& Get() const
+    {
+        assert(gMetaNodes[mNodeType].mName == Param::Node::NodeName());
+        assert(gMetaNodes[mNodeType].mParametersLayout[Param::Index].mOffset == Param::Offset);
+        return *reinterpret_cast<const typename Param::Type*>(mDump.data() + Param::Offset);
+    }
+
 protected:
     std::vector<unsigned char> mDump;
     uint16_t mNodeType;
 
-    template<typename type> type GetParameter(const char* parameterName, type defaultValue, ConTypes parameterType) const;
-    template<typename type> type* GetParameterPtr(const char* parameterName, type* defaultValue, ConTypes parameterType) const;
+    template<typename type> type GetParameter(const ParameterHandle& handle, type defaultValue, ConTypes parameterType) const;
+    template<typename type> type* GetParameterPtr(const ParameterHandle& handle, type* defaultValue, ConTypes parameterType) const;
 
 };
 
+void MigrateParameterBlocks(const ParameterMigration& migration, ParameterBlock* blocks, size_t count);
@@ -0,0 +1,213 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <string.h>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include "Trace.h"
+#include "MappedFile.h"
+#include "Utils.h"
+
+struct TraceSession
+{
+    MappedFile mFile;
+    TraceFileHeader* mHeader;
+    TraceEvent* mEvents;
+    uint64_t mMask;
+};
+
+static std::mutex gTraceMutex; // start and stop
+static std::atomic<TraceSession*> gTraceSession{ nullptr };
+// writers using the session, StopTrace waits for them before unmapping
+static std::atomic<int> gTraceWriters{ 0 };
+static std::atomic<int64_t> gTraceStart{ 0 };
+static std::atomic<uint16_t> gTraceThreadCount{ 0 };
+
+static int64_t GetSteadyTime()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static uint16_t GetTraceThread()
+{
+    static thread_local uint16_t thread = gTraceThreadCount.fetch_add(1, std::memory_order_relaxed);
+    return thread;
+}
+
+const char* GetTraceEventName(uint16_t id)
+{
+    static const char* names[] = {
+        "NodeLibraryLoad",
+        "NodeFileParse",
+        "NodeLibraryReload",
+        "ParameterParse",
+        "ParameterMigration",
+        "NodeEvaluation",
+        "ParameterChange",
+        "Marker",
+    };
+    static_assert(sizeof(names) / sizeof(names[0]) == TraceEvent_Count, "missing trace event name");
+    return (id < TraceEvent_Count) ? names[id] : "Unknown";
+}
+
+// session is no longer published: waits for the writers still using it
+static void DeleteTraceSession(TraceSession* session)
+{
+    if (!session)
+    {
+        return;
+    }
+    while (gTraceWriters.load())
+    {
+        std::this_thread::yield();
+    }
+    delete session;
+}
+
+bool StartTrace(const char* filename, size_t eventCapacity)
+{
+    // start and stop are serialized: concurrent starts can't both publish a session. The running
+    // session is stopped before creating the file, it may be the same file and still mapped.
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    DeleteTraceSession(gTraceSession.exchange(nullptr));
+
+    uint64_t capacity = 1;
+    while (capacity < eventCapacity)
+    {
+        capacity <<= 1;
+    }
+    TraceSession* session = new TraceSession;
+    if (!session->mFile.Create(filename, sizeof(TraceFileHeader) + size_t(capacity) * sizeof(TraceEvent)))
+    {
+        Log("Unable to create trace file %s\n", filename);
+        delete session;
+        return false;
+    }
+    // a new file is zero filled: no event has a valid sequence
+    uint8_t* data = session->mFile.WritableData();
+    session->mHeader = (TraceFileHeader*)data;
+    session->mEvents = (TraceEvent*)(data + sizeof(TraceFileHeader));
+    session->mMask = capacity - 1;
+    TraceFileHeader& header = *session->mHeader;
+    header.mMagic = TraceMagic;
+    header.mVersion = TraceVersion;
+    header.mEventCapacity = capacity;
+    header.mStartTime = uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count());
+    header.mWritePosition.store(0, std::memory_order_relaxed);
+
+    gTraceStart = GetSteadyTime();
+    gTraceSession = session;
+    return true;
+}
+
+void StopTrace()
+{
+    std::lock_guard<std::mutex> lock(gTraceMutex);
+    DeleteTraceSession(gTraceSession.exchange(nullptr));
+}
+
+bool IsTracing()
+{
+    return gTraceSession.load(std::memory_order_relaxed) != nullptr;
+}
+
+uint64_t GetTraceTime()
+{
+    return uint64_t(GetSteadyTime() - gTraceStart.load(std::memory_order_relaxed));
+}
+
+void Trace(TraceEventId id, int32_t nodeIndex, int32_t parameterIndex)
+{
+    if (IsTracing())
+    {
+        TraceSpan(id, nodeIndex, parameterIndex, GetTraceTime(), 0);
+    }
+}
+
+void TraceSpan(TraceEventId id, int32_t nodeIndex, int32_t parameterIndex, uint64_t startTime, uint64_t duration)
+{
+    if (!IsTracing())
+    {
+        return;
+    }
+    gTraceWriters.fetch_add(1);
+    TraceSession* session = gTraceSession.load();
+    if (session)
+    {
+        const uint64_t position = session->mHeader->mWritePosition.fetch_add(1, std::memory_order_relaxed);
+        TraceEvent& event = session->mEvents[position & session->mMask];
+        // the slot may still hold an older event, invalidate it while it is being overwritten
+        event.mSequence.store(0, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        event.mId = id;
+        event.mThread = GetTraceThread();
+        event.mTimestamp = startTime;
+        event.mDuration = duration;
+        event.mNodeIndex = nodeIndex;
+        event.mParameterIndex = parameterIndex;
+        event.mSequence.store(uint32_t(position + 1), std::memory_order_release);
+    }
+    gTraceWriters.fetch_sub(1, std::memory_order_release);
+}
+
+const TraceFileHeader* GetTraceFileHeader(const uint8_t* data, size_t size)
+{
+    if (!data || size < sizeof(TraceFileHeader))
+    {
+        return nullptr;
+    }
+    const TraceFileHeader* header = (const TraceFileHeader*)data;
+    const uint64_t capacity = header->mEventCapacity;
+    if (header->mMagic != TraceMagic || header->mVersion != TraceVersion || !capacity || (capacity & (capacity - 1)) ||
+        capacity > (size - sizeof(TraceFileHeader)) / sizeof(TraceEvent))
+    {
+        return nullptr;
+    }
+    return header;
+}
+
+uint64_t GetTraceEvents(const TraceFileHeader* header, std::vector<const TraceEvent*>& events)
+{
+    events.clear();
+    const TraceEvent* ring = (const TraceEvent*)(header + 1);
+    const uint64_t capacity = header->mEventCapacity;
+    const uint64_t writePosition = header->mWritePosition.load();
+    const uint64_t first = (writePosition > capacity) ? writePosition - capacity : 0;
+    uint64_t skipped = 0;
+    for (uint64_t position = first; position < writePosition; position++)
+    {
+        const TraceEvent& event = ring[position & (capacity - 1)];
+        if (event.mSequence.load() != uint32_t(position + 1))
+        {
+            skipped++;
+            continue;
+        }
+        events.push_back(&event);
+    }
+    return skipped;
+}
@@ -0,0 +1,124 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <stdint.h>
+#include <stddef.h>
+#include <atomic>
+#include <vector>
+
+// Binary trace: fixed size events written by any thread into a ring stored in a memory mapped
+// file. Once the ring is full, the oldest events are overwritten. Use TraceDecoder to convert a
+// trace file to Chrome trace JSON (chrome://tracing, Perfetto).
+
+enum TraceEventId : uint16_t
+{
+    TraceEvent_NodeLibraryLoad,
+    TraceEvent_NodeFileParse,     // node index is the file index
+    TraceEvent_NodeLibraryReload, // node index is the first added node
+    TraceEvent_ParameterParse,    // parameter index is the request count
+    TraceEvent_ParameterMigration, // node index is the node type
+    TraceEvent_NodeEvaluation,
+    TraceEvent_ParameterChange,
+    TraceEvent_Marker,
+
+    TraceEvent_Count
+};
+
+const char* GetTraceEventName(uint16_t id);
+
+static const uint32_t TraceMagic = 0x43525447; // 'GTRC'
+static const uint32_t TraceVersion = 1;
+
+struct TraceFileHeader
+{
+    uint32_t mMagic;
+    uint32_t mVersion;
+    uint64_t mEventCapacity;
+    uint64_t mStartTime; // system clock, ns since epoch
+    std::atomic<uint64_t> mWritePosition; // events written since the start, the ring index is modulo capacity
+    uint64_t mPadding[4];
+};
+
+// 32 bytes. mSequence is written last: it is the low 32 bits of (position + 1) once the event is complete.
+struct TraceEvent
+{
+    std::atomic<uint32_t> mSequence;
+    uint16_t mId;
+    uint16_t mThread;
+    uint64_t mTimestamp; // ns since the trace start
+    uint64_t mDuration;  // ns, 0 for instant events
+    int32_t mNodeIndex;
+    int32_t mParameterIndex;
+};
+
+static_assert(sizeof(TraceFileHeader) == 64, "trace file layout");
+static_assert(sizeof(TraceEvent) == 32, "trace file layout");
+
+// eventCapacity is rounded up to a power of 2. A running trace is stopped first.
+bool StartTrace(const char* filename, size_t eventCapacity = 1 << 20);
+void StopTrace();
+bool IsTracing();
+
+// ns since the trace start
+uint64_t GetTraceTime();
+// Instant event
+void Trace(TraceEventId id, int32_t nodeIndex = -1, int32_t parameterIndex = -1);
+// Complete event, times from GetTraceTime
+void TraceSpan(TraceEventId id, int32_t nodeIndex, int32_t parameterIndex, uint64_t startTime, uint64_t duration);
+
+// Trace file reading (TraceDecoder). Returns nullptr when data is not a valid trace file.
+const TraceFileHeader* GetTraceFileHeader(const uint8_t* data, size_t size);
+// Events left in the ring, oldest first. Events being written when the trace ended (crash) don't have
+// the expected sequence: they are skipped, returns their count.
+uint64_t GetTraceEvents(const TraceFileHeader* header, std::vector<const TraceEvent*>& events);
+
+// Records a complete event when it goes out of scope
+struct TraceScope
+{
+    TraceScope(TraceEventId id, int32_t nodeIndex = -1, int32_t parameterIndex = -1)
+        : mId(id), mNodeIndex(nodeIndex), mParameterIndex(parameterIndex), mbTracing(IsTracing())
+    {
+        mStartTime = mbTracing ? GetTraceTime() : 0;
+    }
+    ~TraceScope()
+    {
+        if (mbTracing)
+        {
+            const uint64_t endTime = GetTraceTime();
+            TraceSpan(mId, mNodeIndex, mParameterIndex, mStartTime, endTime - mStartTime);
+        }
+    }
+    TraceScope(const TraceScope&) = delete;
+    TraceScope& operator=(const TraceScope&) = delete;
+
+    TraceEventId mId;
+    int32_t mNodeIndex;
+    int32_t mParameterIndex;
+    bool mbTracing;
+    uint64_t mStartTime;
+};
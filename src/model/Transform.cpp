@@ -0,0 +1,269 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <assert.h>
+#include "Transform.h"
+
+namespace
+{
+    // transforms per worker chunk when converting to matrices
+    const size_t MatrixGrainSize = 1024;
+
+#if defined(GEMONI_SSE)
+    inline __m128 Load(const Quat& q) { return _mm_loadu_ps(&q.x); }
+    inline Quat Store(__m128 v)
+    {
+        Quat q;
+        _mm_storeu_ps(&q.x, v);
+        return q;
+    }
+    inline float Dot4(__m128 a, __m128 b)
+    {
+        __m128 dot = _mm_mul_ps(a, b);
+        dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(2, 3, 0, 1)));
+        dot = _mm_add_ps(dot, _mm_shuffle_ps(dot, dot, _MM_SHUFFLE(1, 0, 3, 2)));
+        return _mm_cvtss_f32(dot);
+    }
+#endif
+
+    inline bool IsUniformScale(const Vec3& scale)
+    {
+        const float tolerance = 1e-4f * fabsf(scale.x);
+        return fabsf(scale.y - scale.x) <= tolerance && fabsf(scale.z - scale.x) <= tolerance;
+    }
+
+    // wa * a + wb * b, normalized
+    Quat Blend(const Quat& a, float wa, const Quat& b, float wb)
+    {
+#if defined(GEMONI_SSE)
+        const __m128 v = _mm_add_ps(_mm_mul_ps(Load(a), _mm_set1_ps(wa)), _mm_mul_ps(Load(b), _mm_set1_ps(wb)));
+        const float lengthSq = Dot4(v, v);
+        return Store(_mm_mul_ps(v, _mm_set1_ps(1.f / sqrtf(lengthSq))));
+#else
+        Quat q = { a.x * wa + b.x * wb, a.y * wa + b.y * wb, a.z * wa + b.z * wb, a.w * wa + b.w * wb };
+        q.Normalize();
+        return q;
+#endif
+    }
+}
+
+Quat Quat::RotationAxis(const Vec4& axis, float angle)
+{
+    const float length = axis.Length();
+    if (length < FLT_EPSILON)
+    {
+        return Identity();
+    }
+    const float s = sinf(angle * 0.5f) / length;
+    return { axis.x * s, axis.y * s, axis.z * s, cosf(angle * 0.5f) };
+}
+
+Quat Quat::RotationYawPitchRoll(float yaw, float pitch, float roll)
+{
+    // roll around z, then pitch around x, then yaw around y
+    return RotationAxis(Vec4(0.f, 0.f, 1.f), roll) * RotationAxis(Vec4(1.f, 0.f, 0.f), pitch) *
+           RotationAxis(Vec4(0.f, 1.f, 0.f), yaw);
+}
+
+Quat Quat::FromMatrix(const Mat4x4& matrix)
+{
+    // row vector matrix is the transposed rotation matrix
+    const float(*m)[4] = matrix.m;
+    const float trace = m[0][0] + m[1][1] + m[2][2];
+    Quat q;
+    if (trace > 0.f)
+    {
+        const float s = sqrtf(trace + 1.f) * 2.f;
+        q.w = 0.25f * s;
+        q.x = (m[1][2] - m[2][1]) / s;
+        q.y = (m[2][0] - m[0][2]) / s;
+        q.z = (m[0][1] - m[1][0]) / s;
+    }
+    else if (m[0][0] > m[1][1] && m[0][0] > m[2][2])
+    {
+        const float s = sqrtf(1.f + m[0][0] - m[1][1] - m[2][2]) * 2.f;
+        q.w = (m[1][2] - m[2][1]) / s;
+        q.x = 0.25f * s;
+        q.y = (m[1][0] + m[0][1]) / s;
+        q.z = (m[2][0] + m[0][2]) / s;
+    }
+    else if (m[1][1] > m[2][2])
+    {
+        const float s = sqrtf(1.f + m[1][1] - m[0][0] - m[2][2]) * 2.f;
+        q.w = (m[2][0] - m[0][2]) / s;
+        q.x = (m[1][0] + m[0][1]) / s;
+        q.y = 0.25f * s;
+        q.z = (m[2][1] + m[1][2]) / s;
+    }
+    else
+    {
+        const float s = sqrtf(1.f + m[2][2] - m[0][0] - m[1][1]) * 2.f;
+        q.w = (m[0][1] - m[1][0]) / s;
+        q.x = (m[2][0] + m[0][2]) / s;
+        q.y = (m[2][1] + m[1][2]) / s;
+        q.z = 0.25f * s;
+    }
+    return q;
+}
+
+Quat Quat::operator*(const Quat& q) const
+{
+    // this then q: Hamilton product q * this
+    return { q.w * x + q.x * w + q.y * z - q.z * y,
+             q.w * y - q.x * z + q.y * w + q.z * x,
+             q.w * z + q.x * y - q.y * x + q.z * w,
+             q.w * w - q.x * x - q.y * y - q.z * z };
+}
+
+void Quat::Normalize()
+{
+    const float lengthSq = x * x + y * y + z * z + w * w;
+    if (lengthSq < FLT_EPSILON)
+    {
+        *this = Identity();
+        return;
+    }
+    const float invLength = 1.f / sqrtf(lengthSq);
+    x *= invLength;
+    y *= invLength;
+    z *= invLength;
+    w *= invLength;
+}
+
+Vec4 Quat::Rotate(const Vec4& v) const
+{
+    // v + 2w (u x v) + 2 u x (u x v)
+    const Vec4 u(x, y, z, 0.f);
+    const Vec4 uv = Cross(u, v) * 2.f;
+    const Vec4 res = v + uv * w + Cross(u, uv);
+    return Vec4(res.x, res.y, res.z, v.w);
+}
+
+void Quat::ToMatrix(Mat4x4& matrix) const
+{
+    matrix.rotationQuaternion(Vec4(x, y, z, w));
+}
+
+Quat Slerp(const Quat& a, const Quat& b, float t)
+{
+    float cosTheta = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    float sign = 1.f;
+    if (cosTheta < 0.f)
+    {
+        cosTheta = -cosTheta;
+        sign = -1.f;
+    }
+    if (cosTheta > 0.9995f)
+    {
+        return Blend(a, 1.f - t, b, t * sign);
+    }
+    const float theta = acosf(cosTheta);
+    const float invSinTheta = 1.f / sinf(theta);
+    return Blend(a, sinf((1.f - t) * theta) * invSinTheta, b, sinf(t * theta) * invSinTheta * sign);
+}
+
+Transform Transform::operator*(const Transform& t) const
+{
+    Transform res;
+    res.mRotation = mRotation * t.mRotation;
+    res.mScale = { mScale.x * t.mScale.x, mScale.y * t.mScale.y, mScale.z * t.mScale.z };
+    Vec4 translation = t.mRotation.Rotate(
+        Vec4(mTranslation.x * t.mScale.x, mTranslation.y * t.mScale.y, mTranslation.z * t.mScale.z));
+    res.mTranslation = { translation.x + t.mTranslation.x,
+                         translation.y + t.mTranslation.y,
+                         translation.z + t.mTranslation.z };
+    return res;
+}
+
+Transform Transform::Inverse() const
+{
+    assert(IsUniformScale(mScale));
+    Transform res;
+    res.mRotation = mRotation.Conjugate();
+    res.mScale = { 1.f / mScale.x, 1.f / mScale.y, 1.f / mScale.z };
+    Vec4 translation = res.mRotation.Rotate(Vec4(-mTranslation.x, -mTranslation.y, -mTranslation.z));
+    res.mTranslation = { translation.x * res.mScale.x, translation.y * res.mScale.y, translation.z * res.mScale.z };
+    return res;
+}
+
+Vec4 Transform::TransformPoint(const Vec4& point) const
+{
+    Vec4 res = mRotation.Rotate(Vec4(point.x * mScale.x, point.y * mScale.y, point.z * mScale.z));
+    return Vec4(res.x + mTranslation.x, res.y + mTranslation.y, res.z + mTranslation.z, 1.f);
+}
+
+void Transform::ToMatrix(Mat4x4& matrix) const
+{
+    mRotation.ToMatrix(matrix);
+    matrix.V.right *= mScale.x;
+    matrix.V.up *= mScale.y;
+    matrix.V.dir *= mScale.z;
+    matrix.V.position.Set(mTranslation.x, mTranslation.y, mTranslation.z, 1.f);
+}
+
+Transform Lerp(const Transform& a, const Transform& b, float t)
+{
+    Transform res;
+    res.mRotation = Slerp(a.mRotation, b.mRotation, t);
+    res.mTranslation = a.mTranslation + (b.mTranslation - a.mTranslation) * t;
+    res.mScale = a.mScale + (b.mScale - a.mScale) * t;
+    return res;
+}
+
+void TransformsToMatrices(const Transform* transforms, Mat4x4* matrices, size_t count)
+{
+    ParallelFor(count, MatrixGrainSize, [transforms, matrices](size_t begin, size_t end) {
+        for (size_t i = begin; i < end; i++)
+        {
+            transforms[i].ToMatrix(matrices[i]);
+        }
+    });
+}
+
+void ConcatenateHierarchy(const Transform* locals, const int* parents, Mat4x4* worlds, size_t count)
+{
+    // local matrices are independent, only the concatenation follows the hierarchy order
+    TransformsToMatrices(locals, worlds, count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const int parent = parents[i];
+        assert(parent < int(i));
+        if (parent >= 0)
+        {
+            worlds[i].Multiply(worlds[parent]);
+        }
+    }
+}
+
+void ConcatenateHierarchy(const Transform* locals, const int* parents, Transform* worlds, size_t count)
+{
+    for (size_t i = 0; i < count; i++)
+    {
+        const int parent = parents[i];
+        assert(parent < int(i));
+        worlds[i] = (parent >= 0) ? locals[i] * worlds[parent] : locals[i];
+    }
+}
@@ -0,0 +1,84 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#pragma once
+
+#include <stddef.h>
+#include "GeometryTypes.h"
+
+// Rotation quaternion. Same convention as Mat4x4::RotationAxis: the matrix of a quaternion
+// transforms row vectors, a * b rotates by a then by b, like matrices.
+struct Quat
+{
+    float x, y, z, w;
+
+    static Quat Identity()
+    {
+        return { 0.f, 0.f, 0.f, 1.f };
+    }
+    static Quat RotationAxis(const Vec4& axis, float angle);
+    static Quat RotationYawPitchRoll(float yaw, float pitch, float roll);
+    // rotation part of an orthonormal matrix
+    static Quat FromMatrix(const Mat4x4& matrix);
+
+    Quat operator*(const Quat& q) const;
+    Quat Conjugate() const
+    {
+        return { -x, -y, -z, w };
+    }
+    void Normalize();
+    Vec4 Rotate(const Vec4& v) const;
+    void ToMatrix(Mat4x4& matrix) const;
+};
+
+// shortest path, falls back to a normalized lerp for close rotations
+Quat Slerp(const Quat& a, const Quat& b, float t);
+
+// Scale, then rotation, then translation. Cheaper than a matrix to interpolate and compose.
+struct Transform
+{
+    Quat mRotation{ 0.f, 0.f, 0.f, 1.f };
+    Vec3 mTranslation{ 0.f, 0.f, 0.f };
+    Vec3 mScale{ 1.f, 1.f, 1.f };
+
+    // a * b applies a then b, like Mat4x4. Exact for uniform scales: a non uniform scale
+    // followed by a rotation is a shear no TRS can hold.
+    Transform operator*(const Transform& t) const;
+    // Uniform scales only (asserted in debug): the inverse of a non uniform scale applies it after the
+    // rotation, use Mat4x4::Inverse on ToMatrix instead.
+    Transform Inverse() const;
+    Vec4 TransformPoint(const Vec4& point) const;
+    void ToMatrix(Mat4x4& matrix) const;
+};
+
+Transform Lerp(const Transform& a, const Transform& b, float t);
+
+void TransformsToMatrices(const Transform* transforms, Mat4x4* matrices, size_t count);
+
+// parents[i] is the parent of transform i, -1 for roots. Parents come before their children.
+// worlds[i] = locals[i] * worlds[parents[i]]
+void ConcatenateHierarchy(const Transform* locals, const int* parents, Mat4x4* worlds, size_t count);
+void ConcatenateHierarchy(const Transform* locals, const int* parents, Transform* worlds, size_t count);
@@ -1,30 +1,300 @@
 #include "Utils.h"
 #include <vector>
-#include <stdarg.h>
-#include <cstdio>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <condition_variable>
+#include <limits>
+#include <climits>
+#include <cfloat>
+#include <clocale>
+#include <cstdlib>
+#include <cstring>
+#include <string>
 
-static std::vector<LogOutput> outputs;
-void AddLogOutput(LogOutput output)
+static bool IsDigit(char c)
 {
-    outputs.push_back(output);
+    return c >= '0' && c <= '9';
 }
 
-int Log(const char* szFormat, ...)
+static bool MatchNoCase(const char* first, const char* last, const char* word)
 {
-    va_list ptr_arg;
-    va_start(ptr_arg, szFormat);
+    for (; *word; first++, word++)
+    {
+        if (first == last || (*first | 0x20) != *word)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// true when value is exactly halfway between two normal floats: its 29 bits below the float
+// mantissa are 100...0
+static bool IsFloatMidpoint(double value)
+{
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(bits));
+    const uint64_t lowMask = (uint64_t(1) << 29) - 1;
+    return (bits & lowMask) == (uint64_t(1) << 28);
+}
+
+// correctly rounded by the C library. The text is copied with the decimal point of the current
+// locale so parsing stays locale independent.
+static void ParseFloatSlow(const char* first, const char* last, float& value)
+{
+    std::string text(first, last);
+    const char decimalPoint = *localeconv()->decimal_point;
+    for (auto& c : text)
+    {
+        c = (c == '.') ? decimalPoint : c;
+    }
+    value = strtof(text.c_str(), nullptr);
+}
+
+const char* ParseFloat(const char* first, const char* last, float& value)
+{
+    // powers of ten exactly representable as double
+    static const double powersOf10[] = { 1e0,  1e1,  1e2,  1e3,  1e4,  1e5,  1e6,  1e7,  1e8,  1e9,  1e10, 1e11,
+                                         1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+    const char* ptr = first;
+    bool negative = false;
+    if (ptr != last && (*ptr == '-' || *ptr == '+'))
+    {
+        negative = *ptr++ == '-';
+    }
+    if (MatchNoCase(ptr, last, "inf"))
+    {
+        value = negative ? -std::numeric_limits<float>::infinity() : std::numeric_limits<float>::infinity();
+        ptr += 3;
+        return MatchNoCase(ptr, last, "inity") ? ptr + 5 : ptr;
+    }
+    if (MatchNoCase(ptr, last, "nan"))
+    {
+        value = std::numeric_limits<float>::quiet_NaN();
+        return ptr + 3;
+    }
+
+    // up to 19 significant digits in an integer, the remaining ones only move the exponent
+    uint64_t mantissa = 0;
+    int digitCount = 0;
+    int exponent = 0;
+    bool hasDigits = false;
+    for (; ptr != last && IsDigit(*ptr); ptr++)
+    {
+        hasDigits = true;
+        if (digitCount < 19)
+        {
+            mantissa = mantissa * 10 + uint64_t(*ptr - '0');
+            digitCount += mantissa ? 1 : 0;
+        }
+        else
+        {
+            exponent++;
+        }
+    }
+    if (ptr != last && *ptr == '.')
+    {
+        ptr++;
+        for (; ptr != last && IsDigit(*ptr); ptr++)
+        {
+            hasDigits = true;
+            if (digitCount < 19)
+            {
+                mantissa = mantissa * 10 + uint64_t(*ptr - '0');
+                digitCount += mantissa ? 1 : 0;
+                exponent--;
+            }
+        }
+    }
+    if (!hasDigits)
+    {
+        return first;
+    }
+    if (ptr != last && (*ptr == 'e' || *ptr == 'E'))
+    {
+        const char* exponentPtr = ptr + 1;
+        bool negativeExponent = false;
+        if (exponentPtr != last && (*exponentPtr == '-' || *exponentPtr == '+'))
+        {
+            negativeExponent = *exponentPtr++ == '-';
+        }
+        if (exponentPtr != last && IsDigit(*exponentPtr))
+        {
+            int explicitExponent = 0;
+            for (; exponentPtr != last && IsDigit(*exponentPtr); exponentPtr++)
+            {
+                explicitExponent = Min(explicitExponent * 10 + (*exponentPtr - '0'), 10000);
+            }
+            exponent += negativeExponent ? -explicitExponent : explicitExponent;
+            ptr = exponentPtr;
+        }
+    }
+
+    // mantissa and power of ten are exact doubles: the double result is correctly rounded. Rounding
+    // it again to float only differs from rounding the exact value when it lands on a float midpoint.
+    // Other cases (long mantissas, large exponents, subnormals, overflow) go through strtof.
+    if (!mantissa)
+    {
+        value = negative ? -0.f : 0.f;
+        return ptr;
+    }
+    if (mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22)
+    {
+        const double result = (exponent < 0) ? double(mantissa) / powersOf10[-exponent]
+                                             : double(mantissa) * powersOf10[exponent];
+        if (result >= FLT_MIN && result <= FLT_MAX && !IsFloatMidpoint(result))
+        {
+            value = float(negative ? -result : result);
+            return ptr;
+        }
+    }
+    ParseFloatSlow(first, ptr, value);
+    return ptr;
+}
+
+const char* ParseInt(const char* first, const char* last, int& value)
+{
+    const char* ptr = first;
+    bool negative = false;
+    if (ptr != last && (*ptr == '-' || *ptr == '+'))
+    {
+        negative = *ptr++ == '-';
+    }
+    if (ptr == last || !IsDigit(*ptr))
+    {
+        return first;
+    }
+    int64_t result = 0;
+    for (; ptr != last && IsDigit(*ptr); ptr++)
+    {
+        result = Min(result * 10 + (*ptr - '0'), int64_t(INT_MAX) + 1);
+    }
+    result = negative ? -result : result;
+    value = int(Max(Min(result, int64_t(INT_MAX)), int64_t(INT_MIN)));
+    return ptr;
+}
+
+struct WorkerPool
+{
+    WorkerPool()
+    {
+        const size_t threadCount = std::thread::hardware_concurrency();
+        for (size_t i = 1; i < threadCount; i++)
+        {
+            mThreads.emplace_back([this]() { WorkerLoop(); });
+        }
+    }
 
-    static char buf[102400];
-    vsprintf(buf, szFormat, ptr_arg);
+    ~WorkerPool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mbQuit = true;
+        }
+        mWake.notify_all();
+        for (auto& thread : mThreads)
+        {
+            thread.join();
+        }
+    }
 
-    static FILE* fp = fopen("log.txt", "wt");
-    if (fp)
+    void Run(size_t count, size_t grainSize, const std::function<void(size_t, size_t)>& job)
+    {
+        std::lock_guard<std::mutex> submitLock(mSubmitMutex);
+        {
+            std::lock_guard<std::mutex> lock(mMutex);
+            mJob = &job;
+            mCount = count;
+            mGrainSize = grainSize;
+            mNext = 0;
+            mActiveWorkers = mThreads.size();
+            mGeneration++;
+        }
+        mWake.notify_all();
+
+        RunChunks(job, count, grainSize);
+
+        std::unique_lock<std::mutex> lock(mMutex);
+        mDone.wait(lock, [this]() { return !mActiveWorkers; });
+        mJob = nullptr;
+    }
+
+    void RunChunks(const std::function<void(size_t, size_t)>& job, size_t count, size_t grainSize)
+    {
+        tInJob = true;
+        size_t begin;
+        while ((begin = mNext.fetch_add(grainSize)) < count)
+        {
+            job(begin, Min(begin + grainSize, count));
+        }
+        tInJob = false;
+    }
+
+    void WorkerLoop()
+    {
+        uint64_t generation = 0;
+        std::unique_lock<std::mutex> lock(mMutex);
+        while (true)
+        {
+            mWake.wait(lock, [&]() { return mbQuit || mGeneration != generation; });
+            if (mbQuit)
+            {
+                return;
+            }
+            generation = mGeneration;
+            const std::function<void(size_t, size_t)>& job = *mJob;
+            const size_t count = mCount;
+            const size_t grainSize = mGrainSize;
+            lock.unlock();
+            RunChunks(job, count, grainSize);
+            lock.lock();
+            if (!--mActiveWorkers)
+            {
+                mDone.notify_all();
+            }
+        }
+    }
+
+    std::vector<std::thread> mThreads;
+    std::mutex mSubmitMutex;
+    std::mutex mMutex;
+    std::condition_variable mWake;
+    std::condition_variable mDone;
+    const std::function<void(size_t, size_t)>* mJob{ nullptr };
+    size_t mCount{ 0 };
+    size_t mGrainSize{ 1 };
+    std::atomic<size_t> mNext{ 0 };
+    size_t mActiveWorkers{ 0 };
+    uint64_t mGeneration{ 0 };
+    bool mbQuit{ false };
+
+    static thread_local bool tInJob;
+};
+
+thread_local bool WorkerPool::tInJob = false;
+
+static WorkerPool& GetWorkerPool()
+{
+    static WorkerPool pool;
+    return pool;
+}
+
+size_t GetWorkerThreadCount()
+{
+    return GetWorkerPool().mThreads.size() + 1;
+}
+
+void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& job)
+{
+    grainSize = Max(grainSize, size_t(1));
+    if (count <= grainSize || WorkerPool::tInJob || GetWorkerThreadCount() == 1)
     {
-        fprintf(fp, "%s", buf);
-        fflush(fp);
+        if (count)
+        {
+            job(0, count);
+        }
+        return;
     }
-    for (auto output : outputs)
-        output(buf);
-    va_end(ptr_arg);
-    return 0;
+    GetWorkerPool().Run(count, grainSize, job);
 }
@@ -1,5 +1,7 @@
 #pragma once
 #include <stdint.h>
+#include <stddef.h>
+#include <functional>
 
 static const float PI = 3.141592f;
 inline float RadToDeg(float a)
@@ -57,6 +59,44 @@ inline uint32_t ColorF32(float R, float G, float B, float A)
     return out;
 }
 
+// FNV-1a
+inline uint32_t HashString(const char* str)
+{
+    uint32_t hash = 2166136261U;
+    while (*str)
+    {
+        hash ^= uint8_t(*str++);
+        hash *= 16777619U;
+    }
+    return hash;
+}
+
+// FNV-1a, 64 bits. Pass a previous result as seed to hash several blocks
+inline uint64_t HashData64(const void* data, size_t size, uint64_t seed = 14695981039346656037ULL)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    uint64_t hash = seed;
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+// Locale independent number parsing, from_chars style: reads a number at the start of [first, last)
+// and returns the position after it, or first when there is no number. value is unchanged on failure.
+// Floats: [+-]digits[.digits][(e|E)[+-]digits], also "inf" and "nan", correctly rounded like strtof.
+// Ints: [+-]digits, clamped to the int range.
+const char* ParseFloat(const char* first, const char* last, float& value);
+const char* ParseInt(const char* first, const char* last, int& value);
+
 typedef void (*LogOutput)(const char* szText);
 void AddLogOutput(LogOutput output);
-int Log(const char* szFormat, ...);
\ No newline at end of file
+// Info severity, formatted on the calling thread and written asynchronously, see Logger.h
+int Log(const char* szFormat, ...);
+
+// Runs job over [0, count) in chunks of grainSize on the worker pool. The calling thread takes
+// part and returns once every chunk is done. Nested calls from a job run serially.
+void ParallelFor(size_t count, size_t grainSize, const std::function<void(size_t begin, size_t end)>& job);
+size_t GetWorkerThreadCount();
@@ -0,0 +1,358 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include <vector>
+#include "GeometryBatch.h"
+#include "Camera.h"
+#include "TestUtils.h"
+
+// batch transforms against the scalar Vec4 path
+
+static const float Tolerance = 1e-4f;
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) <= Tolerance * (1.f + fabsf(b));
+}
+
+static Mat4x4 GetTestMatrix()
+{
+    Mat4x4 matrix;
+    matrix.RotationAxis(Vec4(1.f, 2.f, 3.f), 0.7f);
+    for (int row = 0; row < 3; row++)
+    {
+        for (int column = 0; column < 3; column++)
+        {
+            matrix.m[row][column] *= 1.5f + 0.25f * row;
+        }
+    }
+    matrix.m[3][0] = 12.f;
+    matrix.m[3][1] = -7.f;
+    matrix.m[3][2] = 3.5f;
+    return matrix;
+}
+
+static std::vector<Vec3> GetTestPoints(size_t count)
+{
+    std::vector<Vec3> points(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        const float t = float(i);
+        points[i] = { sinf(t * 0.37f) * 100.f, cosf(t * 0.11f) * 50.f - 20.f, fmodf(t * 1.7f, 300.f) - 150.f };
+    }
+    return points;
+}
+
+static Vec3 ScalarTransform(const Mat4x4& matrix, const Vec3& point, bool isPoint)
+{
+    Vec4 res(point.x, point.y, point.z, isPoint ? 1.f : 0.f);
+    if (isPoint)
+    {
+        res.TransformPoint(matrix);
+    }
+    else
+    {
+        res.TransformVector(matrix);
+    }
+    return { res.x, res.y, res.z };
+}
+
+static bool CheckResults(const Mat4x4& matrix,
+                         const std::vector<Vec3>& source,
+                         const float* x, const float* y, const float* z,
+                         size_t stride,
+                         bool isPoint,
+                         const Bounds* bounds)
+{
+    Bounds expectedBounds;
+    bool match = true;
+    for (size_t i = 0; i < source.size() && match; i++)
+    {
+        const Vec3 expected = ScalarTransform(matrix, source[i], isPoint);
+        match = Near(x[i * stride], expected.x) && Near(y[i * stride], expected.y) && Near(z[i * stride], expected.z);
+        expectedBounds.AddPoint(expected);
+    }
+    if (bounds && match)
+    {
+        match = (source.empty() && bounds->IsEmpty()) ||
+                (Near(bounds->mMin.x, expectedBounds.mMin.x) && Near(bounds->mMin.y, expectedBounds.mMin.y) &&
+                 Near(bounds->mMin.z, expectedBounds.mMin.z) && Near(bounds->mMax.x, expectedBounds.mMax.x) &&
+                 Near(bounds->mMax.y, expectedBounds.mMax.y) && Near(bounds->mMax.z, expectedBounds.mMax.z));
+    }
+    if (!match)
+    {
+        fprintf(stderr, "  mismatch for %zu %s\n", source.size(), isPoint ? "points" : "vectors");
+    }
+    return match;
+}
+
+// empty, below one vector of lanes, odd counts and counts split over the worker threads
+static const size_t TestCounts[] = { 0, 1, 3, 7, 8, 13, 1023, 16384, 16384 * 3 + 5, 100003 };
+
+static void TestStructureOfArrays()
+{
+    const Mat4x4 matrix = GetTestMatrix();
+    for (size_t count : TestCounts)
+    {
+        const std::vector<Vec3> source = GetTestPoints(count);
+        std::vector<float> x(count), y(count), z(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            x[i] = source[i].x;
+            y[i] = source[i].y;
+            z[i] = source[i].z;
+        }
+        std::vector<float> outX(count), outY(count), outZ(count);
+
+        Bounds bounds;
+        TransformPoints(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), count, &bounds);
+        TEST_CHECK(CheckResults(matrix, source, outX.data(), outY.data(), outZ.data(), 1, true, &bounds));
+
+        TransformPoints(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), count);
+        TEST_CHECK(CheckResults(matrix, source, outX.data(), outY.data(), outZ.data(), 1, true, nullptr));
+
+        TransformVectors(matrix, x.data(), y.data(), z.data(), outX.data(), outY.data(), outZ.data(), count);
+        TEST_CHECK(CheckResults(matrix, source, outX.data(), outY.data(), outZ.data(), 1, false, nullptr));
+
+        // in place
+        Bounds inPlaceBounds;
+        TransformPoints(matrix, x.data(), y.data(), z.data(), x.data(), y.data(), z.data(), count, &inPlaceBounds);
+        TEST_CHECK(CheckResults(matrix, source, x.data(), y.data(), z.data(), 1, true, &inPlaceBounds));
+    }
+}
+
+static void TestPacked()
+{
+    const Mat4x4 matrix = GetTestMatrix();
+    for (size_t count : TestCounts)
+    {
+        const std::vector<Vec3> source = GetTestPoints(count);
+        std::vector<Vec3> out(count);
+        const float* outFloats = count ? &out[0].x : nullptr;
+
+        Bounds bounds;
+        TransformPoints(matrix, source.data(), out.data(), count, &bounds);
+        TEST_CHECK(CheckResults(matrix, source, outFloats, outFloats + 1, outFloats + 2, 3, true, &bounds));
+
+        TransformVectors(matrix, source.data(), out.data(), count);
+        TEST_CHECK(CheckResults(matrix, source, outFloats, outFloats + 1, outFloats + 2, 3, false, nullptr));
+
+        // in place
+        std::vector<Vec3> points = source;
+        const float* pointFloats = count ? &points[0].x : nullptr;
+        Bounds inPlaceBounds;
+        TransformPoints(matrix, points.data(), points.data(), count, &inPlaceBounds);
+        TEST_CHECK(CheckResults(matrix, source, pointFloats, pointFloats + 1, pointFloats + 2, 3, true, &inPlaceBounds));
+
+        points = source;
+        TransformVectors(matrix, points.data(), points.data(), count);
+        TEST_CHECK(CheckResults(matrix, source, pointFloats, pointFloats + 1, pointFloats + 2, 3, false, nullptr));
+    }
+}
+
+static void TestBoundsAccumulate()
+{
+    // bounds passed in are extended, not replaced
+    const Mat4x4 matrix = GetTestMatrix();
+    const std::vector<Vec3> source = GetTestPoints(37);
+    std::vector<Vec3> out(source.size());
+    Bounds bounds;
+    bounds.AddPoint({ 10000.f, 10000.f, 10000.f });
+    TransformPoints(matrix, source.data(), out.data(), source.size(), &bounds);
+    TEST_CHECK(bounds.mMax.x == 10000.f && bounds.mMax.y == 10000.f && bounds.mMax.z == 10000.f);
+    TEST_CHECK(bounds.mMin.x < 10000.f && bounds.mMin.y < 10000.f && bounds.mMin.z < 10000.f);
+}
+
+static bool NearMatrix(const Mat4x4& a, const Mat4x4& b)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        if (!Near(a.m16[i], b.m16[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static Mat4x4 GetRigidMatrix(float angle)
+{
+    Mat4x4 matrix;
+    matrix.RotationAxis(Vec4(1.f, 2.f, 3.f), angle);
+    matrix.m[3][0] = -4.f;
+    matrix.m[3][1] = 9.f;
+    matrix.m[3][2] = 0.5f;
+    return matrix;
+}
+
+static Mat4x4 GetProjectiveMatrix()
+{
+    Mat4x4 matrix = GetTestMatrix();
+    matrix.m[0][3] = 0.1f;
+    matrix.m[2][3] = -0.05f;
+    matrix.m[3][3] = 2.f;
+    return matrix;
+}
+
+// general, affine and rigid matrices, reference is the general inverse
+static Mat4x4 GetInverseTestMatrix(size_t index)
+{
+    switch (index % 3)
+    {
+    case 0:
+        return GetProjectiveMatrix();
+    case 1:
+        return GetTestMatrix();
+    default:
+        return GetRigidMatrix(0.1f * float(index));
+    }
+}
+
+static bool CheckInverse(const Mat4x4& matrix, bool rigid = false)
+{
+    Mat4x4 expected;
+    const float expectedDeterminant = expected.Inverse(matrix);
+    Mat4x4 inverse;
+    const float determinant = rigid ? inverse.InverseRigid(matrix) : inverse.InverseAuto(matrix);
+    // and back to identity
+    Mat4x4 identity;
+    identity.Identity();
+    return NearMatrix(inverse, expected) && NearMatrix(matrix * inverse, identity) &&
+           Near(determinant, expectedDeterminant);
+}
+
+static void TestInverse()
+{
+    const Mat4x4 projective = GetProjectiveMatrix();
+    TEST_CHECK(!projective.IsAffine() && !projective.IsRigid());
+    TEST_CHECK(CheckInverse(projective));
+
+    const Mat4x4 affine = GetTestMatrix();
+    TEST_CHECK(affine.IsAffine() && !affine.IsRigid());
+    TEST_CHECK(CheckInverse(affine));
+    Mat4x4 affineInverse, expected;
+    affineInverse.Inverse(affine, true);
+    expected.Inverse(affine);
+    TEST_CHECK(NearMatrix(affineInverse, expected));
+
+    const Mat4x4 rigid = GetRigidMatrix(0.7f);
+    TEST_CHECK(rigid.IsAffine() && rigid.IsRigid());
+    TEST_CHECK(CheckInverse(rigid));
+    TEST_CHECK(CheckInverse(rigid, true));
+
+    // a reflection is orthonormal too
+    Mat4x4 mirror = rigid;
+    mirror.V.up *= -1.f;
+    mirror.m[1][3] = 0.f;
+    TEST_CHECK(mirror.IsRigid());
+    TEST_CHECK(CheckInverse(mirror));
+    TEST_CHECK(CheckInverse(mirror, true));
+
+    // singular: the determinant is reported, whatever path is taken
+    Mat4x4 flat = GetTestMatrix();
+    flat.V.dir.Set(0.f, 0.f, 0.f, 0.f);
+    TEST_CHECK(!flat.IsRigid());
+    Mat4x4 flatInverse;
+    TEST_CHECK(flatInverse.InverseAuto(flat) == 0.f);
+    TEST_CHECK(flatInverse.Inverse(flat) == 0.f);
+    Mat4x4 degenerate = projective;
+    degenerate.V.up = degenerate.V.right;
+    TEST_CHECK(flatInverse.InverseAuto(degenerate) == 0.f);
+
+    // in place
+    for (size_t i = 0; i < 3; i++)
+    {
+        const Mat4x4 matrix = GetInverseTestMatrix(i);
+        Mat4x4 inverse = matrix;
+        inverse.InverseAuto(inverse);
+        expected.Inverse(matrix);
+        TEST_CHECK(NearMatrix(inverse, expected));
+    }
+    Mat4x4 rigidInverse = rigid;
+    rigidInverse.InverseRigid(rigidInverse);
+    expected.Inverse(rigid);
+    TEST_CHECK(NearMatrix(rigidInverse, expected));
+}
+
+static void TestInverseBatch()
+{
+    // split over several worker chunks
+    for (size_t count : { size_t(0), size_t(5), size_t(1024 * 4 + 3) })
+    {
+        std::vector<Mat4x4> source(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            source[i] = GetInverseTestMatrix(i);
+        }
+        std::vector<Mat4x4> out(count);
+        InverseBatch(source.data(), out.data(), count);
+        std::vector<Mat4x4> inPlace = source;
+        InverseBatch(inPlace.data(), inPlace.data(), count);
+
+        bool match = true;
+        for (size_t i = 0; i < count && match; i++)
+        {
+            Mat4x4 expected;
+            expected.Inverse(source[i]);
+            match = NearMatrix(out[i], expected) && NearMatrix(inPlace[i], expected);
+        }
+        TEST_CHECK(match);
+    }
+}
+
+// lens defaults: far stays past near whatever near is
+static void TestCameraLens()
+{
+    static const Vec4 lenses[] = {
+        { 0.f, 0.f, 0.f, 0.f },
+        { 60.f, 1.f, 0.5f, 500.f },
+        { 60.f, 1.f, 100.f, 0.f },
+        { 60.f, 1.f, 250.f, 0.f },
+        { 60.f, 1.f, 250.f, 200.f },
+        { 60.f, 1.f, 250.f, 250.f },
+    };
+    for (const auto& lens : lenses)
+    {
+        Camera camera = {};
+        camera.mLens = lens;
+        TEST_CHECK(camera.GetNear() > 0.f);
+        TEST_CHECK(camera.GetFar() > camera.GetNear());
+        TEST_CHECK(lens.w <= lens.z || camera.GetFar() == lens.w);
+    }
+    Camera camera = {};
+    TEST_CHECK(camera.GetNear() == 0.01f && camera.GetFar() == 100.f && camera.GetFov() == 53.f);
+}
+
+int main(int, char**)
+{
+    TEST_RUN(TestStructureOfArrays);
+    TEST_RUN(TestPacked);
+    TEST_RUN(TestBoundsAccumulate);
+    TEST_RUN(TestInverse);
+    TEST_RUN(TestInverseBatch);
+    TEST_RUN(TestCameraLens);
+    return TestResult();
+}
@@ -0,0 +1,211 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdint.h>
+#include <string.h>
+#include <condition_variable>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Logger.h"
+#include "Utils.h"
+#include "TestUtils.h"
+
+// messages received by the log output, written by the log thread
+static std::mutex gMessagesMutex;
+static std::vector<std::string> gMessages;
+
+// while set, the log output blocks the log thread on the first message starting with "block"
+static std::condition_variable gBlockReleased;
+static bool gbBlockOutput = false;
+static bool gbOutputBlocked = false;
+
+static void TestOutput(const char* text)
+{
+    std::unique_lock<std::mutex> lock(gMessagesMutex);
+    gMessages.push_back(text);
+    if (gbBlockOutput && !strncmp(text, "block", 5))
+    {
+        gbOutputBlocked = true;
+        gBlockReleased.notify_all();
+        gBlockReleased.wait(lock, []() { return !gbBlockOutput; });
+    }
+}
+
+static std::vector<std::string> TakeMessages()
+{
+    FlushLog();
+    std::lock_guard<std::mutex> lock(gMessagesMutex);
+    std::vector<std::string> messages;
+    messages.swap(gMessages);
+    return messages;
+}
+
+static void TestDeferredFormatting()
+{
+    const std::string name("Blur");
+    LogInfo("node %s has %d parameters\n", name, 3);
+    LogWarning("%5.2f|%-4d|%x|%c|%%|%s\n", 3.14159, 7, 255u, 'A', "text");
+    LogError("%lld %llu %zu %.1f %d\n", -5ll, 18446744073709551615ull, size_t(42), 2, 2.75);
+    LogInfo("%8s|%-6s|\n", "ab", "cd");
+    // missing arguments and unknown conversions are written as is
+    LogInfo("%d %s %d %n\n", 1);
+    const char* null = nullptr;
+    LogInfo("%s\n", null);
+
+    const std::vector<std::string> messages = TakeMessages();
+    TEST_CHECK(messages.size() == 6);
+    if (messages.size() == 6)
+    {
+        TEST_CHECK(messages[0] == "node Blur has 3 parameters\n");
+        TEST_CHECK(messages[1] == "Warning:  3.14|7   |ff|A|%|text\n");
+        TEST_CHECK(messages[2] == "Error: -5 18446744073709551615 42 2.0 2\n");
+        TEST_CHECK(messages[3] == "      ab|cd    |\n");
+        TEST_CHECK(messages[4] == "1 %s %d %n\n");
+        TEST_CHECK(messages[5] == "(null)\n");
+    }
+}
+
+static void TestLongMessages()
+{
+    // formatted by Log: longer than a slot, written from the heap
+    const std::string text(1000, 'x');
+    Log("%s|%d\n", text.c_str(), 12);
+    // deferred: strings are truncated to the slot, the arguments that don't fit are lost
+    LogInfo("%s|%d\n", text, 12);
+    Log("%s\n", "short");
+
+    const std::vector<std::string> messages = TakeMessages();
+    TEST_CHECK(messages.size() == 3);
+    if (messages.size() == 3)
+    {
+        TEST_CHECK(messages[0] == text + "|12\n");
+        const size_t length = messages[1].find_first_not_of('x');
+        TEST_CHECK(length > 200 && length < 256);
+        TEST_CHECK(messages[1].substr(length) == "|%d\n");
+        TEST_CHECK(messages[2] == "short\n");
+    }
+}
+
+// the log thread is blocked while several threads overflow the ring: every message is either
+// written or counted as dropped, and the dropped count is reported
+static void TestDroppedCount()
+{
+    static const int ThreadCount = 4;
+    static const int MessageCount = 8192;
+    const uint64_t droppedBefore = GetDroppedLogCount();
+
+    {
+        std::unique_lock<std::mutex> lock(gMessagesMutex);
+        gbBlockOutput = true;
+    }
+    Log("block\n");
+    {
+        std::unique_lock<std::mutex> lock(gMessagesMutex);
+        gBlockReleased.wait(lock, []() { return gbOutputBlocked; });
+    }
+
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < ThreadCount; thread++)
+    {
+        threads.emplace_back([thread]() {
+            for (int i = 0; i < MessageCount; i++)
+            {
+                if (i & 1)
+                {
+                    LogInfo("message %d %d\n", thread, i);
+                }
+                else
+                {
+                    Log("message %d %d\n", thread, i);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    const uint64_t dropped = GetDroppedLogCount() - droppedBefore;
+
+    {
+        std::unique_lock<std::mutex> lock(gMessagesMutex);
+        gbBlockOutput = false;
+        gbOutputBlocked = false;
+    }
+    gBlockReleased.notify_all();
+
+    const std::vector<std::string> messages = TakeMessages();
+    uint64_t written = 0;
+    uint64_t reported = 0;
+    for (auto& message : messages)
+    {
+        unsigned long long count;
+        if (!strncmp(message.c_str(), "message ", 8))
+        {
+            written++;
+        }
+        else if (sscanf(message.c_str(), "%llu log messages dropped", &count) == 1)
+        {
+            reported += count;
+        }
+    }
+    // the ring holds at most one slot per message, the log thread was stuck on the first one
+    TEST_CHECK(dropped >= uint64_t(ThreadCount * MessageCount) - 8192);
+    TEST_CHECK(written + dropped == uint64_t(ThreadCount * MessageCount));
+    TEST_CHECK(reported == dropped);
+}
+
+// registered before the logger is created: runs once its thread is stopped, messages are then
+// formatted and written on the calling thread
+static void TestSynchronousLogging()
+{
+    TakeMessages();
+    LogWarning("stopped %d %s %.1f\n", 7, "log", 0.5);
+    Log("stopped %d\n", 8);
+    bool passed = false;
+    {
+        std::lock_guard<std::mutex> lock(gMessagesMutex);
+        passed = gMessages.size() == 2 && gMessages[0] == "Warning: stopped 7 log 0.5\n" && gMessages[1] == "stopped 8\n";
+    }
+    printf("%s TestSynchronousLogging\n", passed ? "[ OK ]" : "[FAIL]");
+    fflush(stdout);
+    if (!passed || gTestFailures)
+    {
+        _Exit(1);
+    }
+}
+
+int main(int, char**)
+{
+    atexit(TestSynchronousLogging);
+    AddLogOutput(TestOutput);
+    TEST_RUN(TestDeferredFormatting);
+    TEST_RUN(TestLongMessages);
+    TEST_RUN(TestDroppedCount);
+    return TestResult();
+}
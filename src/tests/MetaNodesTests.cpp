@@ -0,0 +1,525 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <string.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#ifdef WIN32
+#include <sys/utime.h>
+#else
+#include <utime.h>
+#endif
+#include <algorithm>
+#include <vector>
+#include "MetaNodes.h"
+#include "MetaNodesCache.h"
+#include "PackedMetaNodes.h"
+#include "Utils.h"
+#include "ParameterBlock.h"
+#include "TestUtils.h"
+
+static const char* TestNodesJson = R"({
+    "nodes": [
+        {
+            "name": "Blur",
+            "category": 3,
+            "color": [ 200, 200, 150, 255 ],
+            "description": "Gaussian blur",
+            "inputs": [ { "name": "Source", "type": "Float4" } ],
+            "outputs": [ { "name": "Out", "type": "Float4" } ],
+            "parameters": [
+                { "name": "strength", "type": "Float", "default": "0.5" },
+                { "name": "radius", "type": "Float", "control": "Slider", "sliderMaxX": 8 },
+                { "name": "passes", "type": "Int", "rangeMinX": 1, "rangeMaxX": 4, "rangeMinY": 0, "rangeMaxY": 0 },
+                { "name": "mode", "type": "Enum", "enum": "Box|Gaussian", "hidden": true }
+            ]
+        }
+    ]
+})";
+
+// leaves non zero bytes on the stack where the next read builds its parameters
+#if defined(_MSC_VER)
+__declspec(noinline)
+#else
+__attribute__((noinline))
+#endif
+static void DirtyStack(unsigned char value)
+{
+    volatile unsigned char buffer[16384];
+    for (size_t i = 0; i < sizeof(buffer); i++)
+    {
+        buffer[i] = value;
+    }
+}
+
+static std::vector<MetaNode> ReadAfterDirtyStack(const char* filename, unsigned char value)
+{
+    DirtyStack(value);
+    return ReadMetaNodes(filename);
+}
+
+static void TestHashIsDeterministic()
+{
+    const std::string filename = WriteTestFile("MetaNodesTests.json", TestNodesJson);
+    const std::vector<MetaNode> first = ReadAfterDirtyStack(filename.c_str(), 0x5A);
+    const std::vector<MetaNode> second = ReadAfterDirtyStack(filename.c_str(), 0xC3);
+    TEST_CHECK(first.size() == 1 && second.size() == 1);
+    if (first.size() != 1 || second.size() != 1)
+    {
+        return;
+    }
+    TEST_CHECK(first[0].mHash != 0);
+    TEST_CHECK(first[0].mHash == second[0].mHash);
+    TEST_CHECK(first[0].mParams.size() == second[0].mParams.size());
+    for (size_t i = 0; i < first[0].mParams.size() && i < second[0].mParams.size(); i++)
+    {
+        TEST_CHECK(first[0].mParams[i].mHash == second[0].mParams[i].mHash);
+    }
+
+    MetaNodesDiff diff;
+    DiffMetaNodes(first, second, diff);
+    TEST_CHECK(diff.mAdded.empty() && diff.mRemoved.empty() && diff.mChanged.empty());
+
+    // parameters without a slider get the defaults
+    const MetaParameter& strength = first[0].mParams[0];
+    TEST_CHECK(strength.mControlType == Control_NumericEdit);
+    TEST_CHECK(strength.mSliderMinX == 0.f && strength.mSliderMaxX == 1.f);
+    const MetaParameter& radius = first[0].mParams[1];
+    TEST_CHECK(radius.mControlType == Control_Slider);
+    TEST_CHECK(radius.mSliderMinX == 0.f && radius.mSliderMaxX == 8.f);
+    remove(filename.c_str());
+}
+
+static void TestPackedHashMatchesJson()
+{
+    const std::string filename = WriteTestFile("MetaNodesTests.json", TestNodesJson);
+    const std::vector<MetaNode> nodes = ReadMetaNodes(filename.c_str());
+    PackedMetaNodes library;
+    library.Build(nodes);
+    std::vector<MetaNode> unpacked;
+    DirtyStack(0x77);
+    library.Unpack(unpacked);
+    TEST_CHECK(unpacked.size() == nodes.size());
+    for (size_t i = 0; i < unpacked.size() && i < nodes.size(); i++)
+    {
+        TEST_CHECK(unpacked[i].mHash == nodes[i].mHash);
+    }
+    remove(filename.c_str());
+}
+
+static void TestEqualityWithoutHash()
+{
+    // built in code, hashes are never computed
+    MetaNode first{};
+    first.mName = "First";
+    MetaNode second = first;
+    TEST_CHECK(first == second);
+    second.mName = "Second";
+    TEST_CHECK(!(first == second));
+
+    MetaParameter param;
+    param.mName = "value";
+    first.mParams.push_back(param);
+    second = first;
+    TEST_CHECK(first == second);
+    second.mParams[0].mType = Con_Int;
+    TEST_CHECK(!(first.mParams[0] == second.mParams[0]));
+    TEST_CHECK(!(first == second));
+}
+
+static MetaNode MakeLayoutTestNode()
+{
+    // mixed sizes and alignments: 4 byte types, a 1024 bytes filename aligned on 1,
+    // a node without storage and a Camera
+    static const ConTypes types[] = { Con_Float, Con_FilenameRead, Con_Int, Con_ForceEvaluate, Con_Camera, Con_Float3,
+                                      Con_Ramp4, Con_Bool };
+    MetaNode node{};
+    node.mName = "LayoutTest";
+    for (size_t i = 0; i < sizeof(types) / sizeof(types[0]); i++)
+    {
+        MetaParameter param;
+        param.mName = "param" + std::to_string(i);
+        param.mType = types[i];
+        node.mParams.push_back(param);
+    }
+    ComputeMetaNodeLayout(node);
+    return node;
+}
+
+static void TestParameterLayout()
+{
+    const MetaNode node = MakeLayoutTestNode();
+    TEST_CHECK(node.mParametersLayout.size() == node.mParams.size());
+    size_t offset = 0;
+    size_t alignment = 1;
+    for (size_t i = 0; i < node.mParams.size(); i++)
+    {
+        const MetaParameterLayout& layout = node.mParametersLayout[i];
+        TEST_CHECK(layout.mSize == GetParameterTypeSize(node.mParams[i].mType));
+        TEST_CHECK(layout.mAlignment == GetParameterTypeAlignment(node.mParams[i].mType));
+        // blocks are tightly packed, the type sizes keep every parameter aligned without padding
+        TEST_CHECK(layout.mOffset == offset);
+        TEST_CHECK(layout.mOffset % layout.mAlignment == 0);
+        offset += layout.mSize;
+        alignment = std::max(alignment, size_t(layout.mAlignment));
+    }
+    TEST_CHECK(node.mParametersSize == offset);
+    TEST_CHECK(node.mParametersAlignment == alignment);
+    TEST_CHECK(node.mParametersAlignment >= alignof(float));
+    TEST_CHECK(node.mFirstParameterOfType[Con_Int] == 2);
+    TEST_CHECK(node.mFirstParameterOfType[Con_Float2] == -1);
+}
+
+static void TestParameterOffset()
+{
+    gMetaNodes.push_back(MakeLayoutTestNode());
+    const uint32_t nodeType = uint32_t(gMetaNodes.size() - 1);
+    const MetaNode& node = gMetaNodes[nodeType];
+    size_t offset = 0;
+    for (uint32_t i = 0; i < node.mParams.size(); i++)
+    {
+        TEST_CHECK(GetParameterOffset(nodeType, i) == offset);
+        offset += GetParameterTypeSize(node.mParams[i].mType);
+    }
+    // past the end is the block size
+    TEST_CHECK(GetParameterOffset(nodeType, uint32_t(node.mParams.size())) == node.mParametersSize);
+    TEST_CHECK(GetParameterOffset(nodeType, 1000) == node.mParametersSize);
+    TEST_CHECK(ComputeNodeParametersSize(nodeType) == node.mParametersSize);
+    gMetaNodes.pop_back();
+}
+
+static void TestIntParameterLookup()
+{
+    gMetaNodes.push_back(MakeLayoutTestNode());
+    const uint16_t nodeType = uint16_t(gMetaNodes.size() - 1);
+    ParameterBlock block(nodeType);
+    block.InitDefault();
+    *(int*)block.Data(2) = 42;
+    // no name is the first Con_Int parameter
+    TEST_CHECK(block.GetIntParameter(nullptr, -1) == 42);
+    TEST_CHECK(block.GetIntParameter("param2", -1) == 42);
+    TEST_CHECK(block.GetIntParameter("param0", -1) == -1);
+    TEST_CHECK(block.GetIntParameter("missing", -1) == -1);
+    gMetaNodes.pop_back();
+}
+
+// attaches a copy of library where one field at fieldAddress is replaced by value
+template<typename T> static bool AttachCorrupted(const PackedMetaNodes& library, const T* fieldAddress, T value)
+{
+    std::vector<uint64_t> image((library.Size() + 7) / 8);
+    memcpy(image.data(), library.Data(), library.Size());
+    uint8_t* data = (uint8_t*)image.data();
+    memcpy(data + ((const uint8_t*)fieldAddress - library.Data()), &value, sizeof(T));
+    PackedMetaNodes corrupted;
+    return corrupted.Attach(data, library.Size());
+}
+
+static void TestAttachRejectsInvalidTypes()
+{
+    const std::string filename = WriteTestFile("MetaNodesTests.json", TestNodesJson);
+    PackedMetaNodes library;
+    library.Build(ReadMetaNodes(filename.c_str()));
+    remove(filename.c_str());
+    TEST_CHECK(library.GetNodes().size() == 1);
+    if (library.GetNodes().size() != 1)
+    {
+        return;
+    }
+    const PackedMetaNode& node = library.GetNodes()[0];
+    const PackedMetaParameter& parameter = library.GetParameters(node)[0];
+    const PackedMetaCon& input = library.GetInputs(node)[0];
+
+    TEST_CHECK(AttachCorrupted(library, &parameter.mType, int32_t(Con_Float)));
+    TEST_CHECK(!AttachCorrupted(library, &parameter.mType, int32_t(Con_Any)));
+    TEST_CHECK(!AttachCorrupted(library, &parameter.mType, int32_t(-1)));
+    TEST_CHECK(!AttachCorrupted(library, &parameter.mType, int32_t(Con_Structure)));
+    // the default value is 4 bytes
+    TEST_CHECK(!AttachCorrupted(library, &parameter.mType, int32_t(Con_Float4)));
+    TEST_CHECK(!AttachCorrupted(library, &parameter.mControlType, int32_t(7)));
+    TEST_CHECK(!AttachCorrupted(library, &input.mType, int32_t(Con_Any)));
+    // offsets written by a build with another layout
+    const PackedMetaParameter& second = library.GetParameters(node)[1];
+    TEST_CHECK(AttachCorrupted(library, &second.mOffset, uint32_t(4)));
+    TEST_CHECK(!AttachCorrupted(library, &second.mOffset, uint32_t(8)));
+    TEST_CHECK(!AttachCorrupted(library, &node.mParametersSize, node.mParametersSize + 4));
+}
+
+static void TestPackedViewBuiltOnDemand()
+{
+    const std::string filename = WriteTestFile("MetaNodesTests.json", TestNodesJson);
+    gMetaNodes = ReadMetaNodes(filename.c_str());
+    remove(filename.c_str());
+    InvalidatePackedMetaNodes();
+    const PackedMetaNodes& library = GetPackedMetaNodes();
+    TEST_CHECK(library.GetNodes().size() == gMetaNodes.size());
+    TEST_CHECK(&GetPackedMetaNodes() == &library && library.Data() == GetPackedMetaNodes().Data());
+    InvalidatePackedMetaNodes();
+    gMetaNodes.clear();
+    TEST_CHECK(GetPackedMetaNodes().GetNodes().empty());
+    InvalidatePackedMetaNodes();
+}
+
+static time_t GetModificationTime(const char* filename)
+{
+    struct stat st;
+    return stat(filename, &st) ? 0 : st.st_mtime;
+}
+
+static void SetModificationTime(const char* filename, time_t time)
+{
+    struct utimbuf times;
+    times.actime = time;
+    times.modtime = time;
+    utime(filename, &times);
+}
+
+static void TestCacheRefreshedAfterTouch()
+{
+    const std::string filename = WriteTestFile("MetaNodesTests.json", TestNodesJson);
+    const char* cacheFilename = "MetaNodesTests.cache";
+    const std::vector<std::string> sourceFilenames = { filename };
+    PackedMetaNodes library;
+    library.Build(ReadMetaNodes(filename.c_str()));
+    TEST_CHECK(SaveMetaNodesCache(cacheFilename, sourceFilenames, library));
+
+    // same content, older timestamps: the cache is used and written again with the new ones
+    SetModificationTime(filename.c_str(), 1000);
+    SetModificationTime(cacheFilename, 1000);
+    PackedMetaNodes cachedLibrary;
+    TEST_CHECK(LoadMetaNodesCache(cacheFilename, sourceFilenames, cachedLibrary));
+    TEST_CHECK(cachedLibrary.Size() == library.Size());
+    TEST_CHECK(GetModificationTime(cacheFilename) > 1000);
+    PackedMetaNodes refreshedLibrary;
+    TEST_CHECK(LoadMetaNodesCache(cacheFilename, sourceFilenames, refreshedLibrary));
+
+    // different content
+    WriteTestFile(filename.c_str(), "{ \"nodes\": [] }");
+    PackedMetaNodes staleLibrary;
+    TEST_CHECK(!LoadMetaNodesCache(cacheFilename, sourceFilenames, staleLibrary));
+    remove(filename.c_str());
+    remove(cacheFilename);
+}
+
+static void TestParseStringsToParameters()
+{
+    // several worker chunks of 1024 requests, every type of number
+    const size_t count = 1024 * 5 + 17;
+    std::vector<std::string> strings(count);
+    std::vector<ParameterParseRequest> requests(count);
+    std::vector<float> values(count * 4, -1.f);
+    static const ConTypes types[] = { Con_Float, Con_Float3, Con_Int, Con_Angle, Con_Int2 };
+    for (size_t i = 0; i < count; i++)
+    {
+        const ConTypes type = types[i % 5];
+        switch (type)
+        {
+        case Con_Float3:
+            strings[i] = std::to_string(i) + ".5, -2e-1 ,3";
+            break;
+        case Con_Int2:
+            strings[i] = std::to_string(i) + ",-7";
+            break;
+        default:
+            strings[i] = std::to_string(i);
+            break;
+        }
+        requests[i] = { strings[i].c_str(), type, &values[i * 4] };
+    }
+    ParseStringsToParameters(requests.data(), count);
+
+    bool match = true;
+    for (size_t i = 0; i < count && match; i++)
+    {
+        const float* value = &values[i * 4];
+        const int* intValue = (const int*)value;
+        switch (types[i % 5])
+        {
+        case Con_Float:
+            match = value[0] == float(i) && value[1] == -1.f;
+            break;
+        case Con_Float3:
+            match = value[0] == float(i) + 0.5f && value[1] == -0.2f && value[2] == 3.f && value[3] == -1.f;
+            break;
+        case Con_Int:
+            match = intValue[0] == int(i) && value[1] == -1.f;
+            break;
+        case Con_Angle:
+            match = value[0] == DegToRad(float(i));
+            break;
+        default:
+            match = intValue[0] == int(i) && intValue[1] == -7 && value[2] == -1.f;
+            break;
+        }
+    }
+    TEST_CHECK(match);
+}
+
+static const char* ReloadNodesJson = R"({
+    "nodes": [
+        {
+            "name": "Sharpen",
+            "category": 1,
+            "color": [ 0, 0, 0, 255 ],
+            "parameters": [ { "name": "strength", "type": "Float", "default": "1" } ]
+        },
+        {
+            "name": "Mix",
+            "category": 1,
+            "color": [ 0, 0, 0, 255 ],
+            "parameters": [
+                { "name": "amount", "type": "Float", "default": "0.25" },
+                { "name": "count", "type": "Int", "default": "3" },
+                { "name": "color", "type": "Float4" },
+                { "name": "extra", "type": "Float" }
+            ]
+        }
+    ]
+})";
+
+// amount is kept and moved, count changes type, color is renamed, extra is removed, offset is new
+static const char* ReloadedNodesJson = R"({
+    "nodes": [
+        {
+            "name": "Sharpen",
+            "category": 1,
+            "color": [ 0, 0, 0, 255 ],
+            "parameters": [ { "name": "strength", "type": "Float", "default": "1" } ]
+        },
+        {
+            "name": "Mix",
+            "category": 1,
+            "color": [ 0, 0, 0, 255 ],
+            "parameters": [
+                { "name": "offset", "type": "Float", "default": "-2" },
+                { "name": "count", "type": "Float", "default": "1.5" },
+                { "name": "amount", "type": "Float", "default": "0.25" },
+                { "name": "tint", "type": "Float4" }
+            ]
+        },
+        {
+            "name": "Added",
+            "category": 1,
+            "color": [ 0, 0, 0, 255 ],
+            "parameters": [ { "name": "value", "type": "Int" } ]
+        }
+    ]
+})";
+
+static std::vector<ParameterMigration> reloadMigrations;
+static void OnMetaNodesReloaded(const std::vector<ParameterMigration>& migrations)
+{
+    reloadMigrations = migrations;
+}
+
+template<typename T> static T GetBlockValue(const ParameterBlock& block, const char* name, T defaultValue)
+{
+    const ParameterHandle handle = GetParameterHandle(block.GetNodeType(), name);
+    if (!handle.IsValid())
+    {
+        return defaultValue;
+    }
+    T value;
+    memcpy(&value, ((const std::vector<uint8_t>&)block).data() + handle.mOffset, sizeof(T));
+    return value;
+}
+
+static void TestReloadMigratesBlocks()
+{
+    const std::string filename = WriteTestFile("MetaNodesTests.json", ReloadNodesJson);
+    gMetaNodes.clear();
+    LoadMetaNodes({ filename });
+    TEST_CHECK(gMetaNodes.size() == 2);
+    const uint16_t sharpenType = uint16_t(GetMetaNodeIndex("Sharpen"));
+    const uint16_t mixType = uint16_t(GetMetaNodeIndex("Mix"));
+    TEST_CHECK(sharpenType == 0 && mixType == 1);
+
+    std::vector<ParameterBlock> blocks;
+    blocks.push_back(ParameterBlock(mixType).InitDefault());
+    blocks.push_back(ParameterBlock(sharpenType).InitDefault());
+    // not in the previous layout
+    blocks.push_back(ParameterBlock(mixType, std::vector<uint8_t>(3, 0xFF)));
+    ParameterBlock& mix = blocks[0];
+    *(float*)mix.Data(0) = 0.75f;
+    *(int*)mix.Data(1) = 7;
+    const float color[4] = { 1.f, 2.f, 3.f, 4.f };
+    memcpy(mix.Data(2), color, sizeof(color));
+    *(float*)mix.Data(3) = 9.f;
+    *(float*)blocks[1].Data(0) = 5.f;
+    const std::vector<uint8_t> sharpenDump = blocks[1];
+
+    AddMetaNodesReloadCallback(OnMetaNodesReloaded);
+    WriteTestFile(filename.c_str(), ReloadedNodesJson);
+    TEST_CHECK(ReloadMetaNodes(filename.c_str()));
+    remove(filename.c_str());
+
+    // indices are stable, new nodes are appended
+    TEST_CHECK(gMetaNodes.size() == 3);
+    TEST_CHECK(GetMetaNodeIndex("Sharpen") == sharpenType && GetMetaNodeIndex("Mix") == mixType);
+    TEST_CHECK(GetMetaNodeIndex("Added") == 2);
+    // only the changed layout is migrated
+    TEST_CHECK(reloadMigrations.size() == 1);
+    if (reloadMigrations.size() != 1)
+    {
+        return;
+    }
+    const ParameterMigration& migration = reloadMigrations[0];
+    TEST_CHECK(migration.mNodeType == mixType);
+    MigrateParameterBlocks(migration, blocks.data(), blocks.size());
+
+    for (auto& block : blocks)
+    {
+        TEST_CHECK(((const std::vector<uint8_t>&)block).size() == gMetaNodes[block.GetNodeType()].mParametersSize);
+    }
+    // kept value, defaults for the type change and the new parameter, nothing from the renamed one
+    TEST_CHECK(GetBlockValue(mix, "amount", 0.f) == 0.75f);
+    TEST_CHECK(GetBlockValue(mix, "count", 0.f) == 1.5f);
+    TEST_CHECK(GetBlockValue(mix, "offset", 0.f) == -2.f);
+    TEST_CHECK(GetBlockValue(mix, "tint", -1.f) == 0.f);
+    TEST_CHECK(GetBlockValue(mix, "extra", -1.f) == -1.f);
+    TEST_CHECK(GetBlockValue(mix, "color", -1.f) == -1.f);
+    // untouched node type
+    TEST_CHECK((const std::vector<uint8_t>&)blocks[1] == sharpenDump);
+    // a block with an unknown layout gets the defaults only
+    TEST_CHECK(GetBlockValue(blocks[2], "amount", 0.f) == 0.25f);
+    TEST_CHECK(GetBlockValue(blocks[2], "offset", 0.f) == -2.f);
+
+    gMetaNodes.clear();
+}
+
+int main(int, char**)
+{
+    TEST_RUN(TestParameterLayout);
+    TEST_RUN(TestParameterOffset);
+    TEST_RUN(TestIntParameterLookup);
+    TEST_RUN(TestHashIsDeterministic);
+    TEST_RUN(TestPackedHashMatchesJson);
+    TEST_RUN(TestEqualityWithoutHash);
+    TEST_RUN(TestAttachRejectsInvalidTypes);
+    TEST_RUN(TestPackedViewBuiltOnDemand);
+    TEST_RUN(TestCacheRefreshedAfterTouch);
+    TEST_RUN(TestReloadMigratesBlocks);
+    TEST_RUN(TestParseStringsToParameters);
+    return TestResult();
+}
@@ -0,0 +1,123 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <algorithm>
+#include <vector>
+#include "NodeSelection.h"
+#include "TestUtils.h"
+
+static std::vector<uint32_t> GetSortedNodes(const NodeSelection& selection)
+{
+    std::vector<uint32_t> nodes = selection.GetNodes();
+    std::sort(nodes.begin(), nodes.end());
+    return nodes;
+}
+
+static void TestSelect()
+{
+    NodeSelection selection;
+    TEST_CHECK(!selection.IsSelected(0));
+    TEST_CHECK(!selection.IsSelected(100000));
+    TEST_CHECK(selection.GetNodes().empty());
+
+    // across bit words, selecting twice is a no-op
+    selection.Select(3, true);
+    selection.Select(64, true);
+    selection.Select(130, true);
+    selection.Select(64, true);
+    TEST_CHECK(selection.IsSelected(3) && selection.IsSelected(64) && selection.IsSelected(130));
+    TEST_CHECK(!selection.IsSelected(2) && !selection.IsSelected(65) && !selection.IsSelected(131));
+    TEST_CHECK(selection.GetNodes().size() == 3);
+
+    // unselecting a node not selected is a no-op
+    selection.Select(4, false);
+    selection.Select(100000, false);
+    TEST_CHECK(selection.GetNodes().size() == 3);
+}
+
+static void TestSwapRemoval()
+{
+    NodeSelection selection;
+    for (uint32_t i = 0; i < 10; i++)
+    {
+        selection.Select(i * 10, true);
+    }
+    // selection order is kept until a removal, which moves the last node in the hole
+    TEST_CHECK(selection.GetNodes()[0] == 0 && selection.GetNodes()[9] == 90);
+    selection.Select(20, false);
+    TEST_CHECK(selection.GetNodes().size() == 9);
+    TEST_CHECK(selection.GetNodes()[2] == 90);
+    TEST_CHECK(!selection.IsSelected(20) && selection.IsSelected(90));
+
+    // removing the moved node and the last one keeps positions consistent
+    selection.Select(90, false);
+    selection.Select(80, false);
+    selection.Select(0, false);
+    const std::vector<uint32_t> expected = { 10, 30, 40, 50, 60, 70 };
+    TEST_CHECK(GetSortedNodes(selection) == expected);
+    for (uint32_t i = 0; i < 100; i++)
+    {
+        const bool listed = std::find(expected.begin(), expected.end(), i) != expected.end();
+        TEST_CHECK(selection.IsSelected(i) == listed);
+    }
+
+    // everything out, in a different order than selected
+    for (uint32_t node : expected)
+    {
+        selection.Select(node, false);
+    }
+    TEST_CHECK(selection.GetNodes().empty());
+    TEST_CHECK(!selection.IsSelected(10));
+}
+
+static void TestClear()
+{
+    NodeSelection selection;
+    for (uint32_t i = 0; i < 1000; i += 3)
+    {
+        selection.Select(i, true);
+    }
+    selection.Clear();
+    TEST_CHECK(selection.GetNodes().empty());
+    bool anySelected = false;
+    for (uint32_t i = 0; i < 1000; i++)
+    {
+        anySelected = anySelected || selection.IsSelected(i);
+    }
+    TEST_CHECK(!anySelected);
+
+    // usable after a clear
+    selection.Select(999, true);
+    selection.Select(1, true);
+    TEST_CHECK(GetSortedNodes(selection) == std::vector<uint32_t>({ 1, 999 }));
+}
+
+int main(int, char**)
+{
+    TEST_RUN(TestSelect);
+    TEST_RUN(TestSwapRemoval);
+    TEST_RUN(TestClear);
+    return TestResult();
+}
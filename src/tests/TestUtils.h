@@ -0,0 +1,72 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string>
+
+// Minimal checks for the test executables: failures are reported and counted, the process exit
+// code is the failure count so ctest sees them.
+
+static int gTestFailures = 0;
+
+#define TEST_CHECK(condition)                                                                                          \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        if (!(condition))                                                                                              \
+        {                                                                                                              \
+            fprintf(stderr, "%s(%d): check failed: %s\n", __FILE__, __LINE__, #condition);                           \
+            gTestFailures++;                                                                                           \
+        }                                                                                                              \
+    } while (0)
+
+#define TEST_RUN(test)                                                                                                 \
+    do                                                                                                                 \
+    {                                                                                                                  \
+        const int failures = gTestFailures;                                                                            \
+        test();                                                                                                        \
+        printf("%s %s\n", (failures == gTestFailures) ? "[ OK ]" : "[FAIL]", #test);                                  \
+    } while (0)
+
+static inline int TestResult()
+{
+    return gTestFailures ? 1 : 0;
+}
+
+// writes content to a file of the working directory, returns its name
+static inline std::string WriteTestFile(const char* filename, const char* content)
+{
+    FILE* fp = fopen(filename, "wt");
+    if (!fp)
+    {
+        fprintf(stderr, "Unable to write %s\n", filename);
+        exit(1);
+    }
+    fputs(content, fp);
+    fclose(fp);
+    return filename;
+}
@@ -0,0 +1,174 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <stdint.h>
+#include <stdio.h>
+#include <string>
+#include <thread>
+#include <vector>
+#include "Trace.h"
+#include "MappedFile.h"
+#include "TestUtils.h"
+
+static const char* TraceTestFile = "TraceTests.trace";
+
+// instant events, the node index is the position
+static void WriteTrace(const char* filename, size_t eventCapacity, int eventCount)
+{
+    TEST_CHECK(StartTrace(filename, eventCapacity));
+    TEST_CHECK(IsTracing());
+    for (int i = 0; i < eventCount; i++)
+    {
+        Trace(TraceEvent_Marker, i, -1);
+    }
+    StopTrace();
+    TEST_CHECK(!IsTracing());
+}
+
+// decodes filename, returns the node indices of the events left in the ring
+static std::vector<int> ReadTrace(const char* filename, uint64_t& writePosition, uint64_t& skipped)
+{
+    std::vector<int> nodeIndices;
+    MappedFile file;
+    TEST_CHECK(file.Open(filename));
+    const TraceFileHeader* header = GetTraceFileHeader(file.Data(), file.Size());
+    TEST_CHECK(header);
+    if (!header)
+    {
+        return nodeIndices;
+    }
+    std::vector<const TraceEvent*> events;
+    skipped = GetTraceEvents(header, events);
+    writePosition = header->mWritePosition.load();
+    for (auto event : events)
+    {
+        TEST_CHECK(event->mId == TraceEvent_Marker && !event->mDuration);
+        nodeIndices.push_back(event->mNodeIndex);
+    }
+    return nodeIndices;
+}
+
+static void SetEventSequence(const char* filename, uint64_t slot, uint32_t sequence)
+{
+    FILE* fp = fopen(filename, "r+b");
+    TEST_CHECK(fp);
+    if (fp)
+    {
+        fseek(fp, long(sizeof(TraceFileHeader) + slot * sizeof(TraceEvent)), SEEK_SET);
+        fwrite(&sequence, sizeof(sequence), 1, fp);
+        fclose(fp);
+    }
+}
+
+static void TestRingWrap()
+{
+    uint64_t writePosition = 0;
+    uint64_t skipped = 0;
+
+    // not full: every event, in order
+    WriteTrace(TraceTestFile, 8, 3);
+    TEST_CHECK(ReadTrace(TraceTestFile, writePosition, skipped) == (std::vector<int>{ 0, 1, 2 }));
+    TEST_CHECK(writePosition == 3 && skipped == 0);
+
+    // the capacity is rounded up to 8, the ring keeps the last 8 events, oldest first
+    WriteTrace(TraceTestFile, 5, 20);
+    TEST_CHECK(ReadTrace(TraceTestFile, writePosition, skipped) ==
+               (std::vector<int>{ 12, 13, 14, 15, 16, 17, 18, 19 }));
+    TEST_CHECK(writePosition == 20 && skipped == 0);
+
+    // exactly full
+    WriteTrace(TraceTestFile, 8, 8);
+    TEST_CHECK(ReadTrace(TraceTestFile, writePosition, skipped) == (std::vector<int>{ 0, 1, 2, 3, 4, 5, 6, 7 }));
+    TEST_CHECK(writePosition == 8 && skipped == 0);
+
+    // not a trace file
+    uint8_t data[sizeof(TraceFileHeader) + sizeof(TraceEvent)] = {};
+    TEST_CHECK(!GetTraceFileHeader(data, sizeof(data)));
+    TEST_CHECK(!GetTraceFileHeader(nullptr, 0));
+}
+
+static void TestDecoderSkipsIncompleteEvents()
+{
+    WriteTrace(TraceTestFile, 8, 20);
+
+    // position 14 (slot 6) was being written: sequence cleared
+    SetEventSequence(TraceTestFile, 14 & 7, 0);
+    // position 17 (slot 1) still holds the event it was overwriting, position 9
+    SetEventSequence(TraceTestFile, 17 & 7, 9 + 1);
+
+    uint64_t writePosition = 0;
+    uint64_t skipped = 0;
+    TEST_CHECK(ReadTrace(TraceTestFile, writePosition, skipped) == (std::vector<int>{ 12, 13, 15, 16, 18, 19 }));
+    TEST_CHECK(writePosition == 20 && skipped == 2);
+}
+
+// starts racing with each other and with writers: every replaced session is stopped (checked by the
+// leak sanitizer) and the last one started stays valid
+static void TestConcurrentStart()
+{
+    static const int ThreadCount = 4;
+    std::vector<std::thread> threads;
+    for (int thread = 0; thread < ThreadCount; thread++)
+    {
+        threads.emplace_back([thread]() {
+            const std::string filename = "TraceTests" + std::to_string(thread) + ".trace";
+            for (int start = 0; start < 20; start++)
+            {
+                TEST_CHECK(StartTrace(filename.c_str(), 64));
+                for (int i = 0; i < 100; i++)
+                {
+                    TraceScope scope(TraceEvent_NodeEvaluation, i);
+                }
+            }
+        });
+    }
+    for (auto& thread : threads)
+    {
+        thread.join();
+    }
+    TEST_CHECK(IsTracing());
+    StopTrace();
+    TEST_CHECK(!IsTracing());
+
+    for (int thread = 0; thread < ThreadCount; thread++)
+    {
+        const std::string filename = "TraceTests" + std::to_string(thread) + ".trace";
+        MappedFile file;
+        TEST_CHECK(file.Open(filename.c_str()));
+        const TraceFileHeader* header = GetTraceFileHeader(file.Data(), file.Size());
+        TEST_CHECK(header && header->mEventCapacity == 64);
+        remove(filename.c_str());
+    }
+}
+
+int main(int, char**)
+{
+    TEST_RUN(TestRingWrap);
+    TEST_RUN(TestDecoderSkipsIncompleteEvents);
+    TEST_RUN(TestConcurrentStart);
+    remove(TraceTestFile);
+    return TestResult();
+}
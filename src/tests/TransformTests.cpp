@@ -0,0 +1,243 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+#include <math.h>
+#include <vector>
+#include "Transform.h"
+#include "TestUtils.h"
+
+// transforms and quaternions against the Mat4x4 products
+
+static const float Tolerance = 1e-4f;
+
+static bool Near(float a, float b)
+{
+    return fabsf(a - b) <= Tolerance * (1.f + fabsf(b));
+}
+
+static bool NearMatrix(const Mat4x4& a, const Mat4x4& b)
+{
+    for (int i = 0; i < 16; i++)
+    {
+        if (!Near(a.m16[i], b.m16[i]))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+// q and -q are the same rotation
+static bool NearRotation(const Quat& a, const Quat& b)
+{
+    const float dot = a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w;
+    return Near(fabsf(dot), 1.f);
+}
+
+static Quat GetTestRotation(size_t index)
+{
+    const float t = float(index);
+    return Quat::RotationAxis(Vec4(sinf(t * 1.3f), cosf(t * 0.7f), 0.5f + fmodf(t, 3.f)), 0.3f + t * 0.9f);
+}
+
+static Transform GetTestTransform(size_t index, bool uniformScale)
+{
+    const float t = float(index);
+    Transform transform;
+    transform.mRotation = GetTestRotation(index);
+    transform.mTranslation = { sinf(t) * 10.f, t * 0.5f - 3.f, cosf(t * 0.3f) * 4.f };
+    const float scale = 0.5f + fmodf(t * 0.37f, 2.f);
+    transform.mScale = { scale, uniformScale ? scale : scale * 1.5f, uniformScale ? scale : scale * 0.75f };
+    return transform;
+}
+
+// scale, then rotation, then translation
+static Mat4x4 GetTRSMatrix(const Transform& transform)
+{
+    Mat4x4 scale, rotation, translation;
+    scale.Scale(transform.mScale.x, transform.mScale.y, transform.mScale.z);
+    transform.mRotation.ToMatrix(rotation);
+    translation.Translation(transform.mTranslation.x, transform.mTranslation.y, transform.mTranslation.z);
+    return scale * rotation * translation;
+}
+
+static Mat4x4 GetMatrix(const Transform& transform)
+{
+    Mat4x4 matrix;
+    transform.ToMatrix(matrix);
+    return matrix;
+}
+
+static void TestQuat()
+{
+    for (size_t i = 0; i < 32; i++)
+    {
+        const float t = float(i);
+        const Vec4 axis(sinf(t * 1.3f), cosf(t * 0.7f), 0.5f + fmodf(t, 3.f));
+        const float angle = 0.3f + t * 0.9f;
+        Mat4x4 expected;
+        expected.RotationAxis(axis, angle);
+        const Quat q = Quat::RotationAxis(axis, angle);
+        Mat4x4 matrix;
+        q.ToMatrix(matrix);
+        TEST_CHECK(NearMatrix(matrix, expected));
+        TEST_CHECK(NearRotation(Quat::FromMatrix(matrix), q));
+
+        // composition order: a then b, like matrices
+        const Quat b = GetTestRotation(i + 7);
+        Mat4x4 bMatrix;
+        b.ToMatrix(bMatrix);
+        Mat4x4 product;
+        (q * b).ToMatrix(product);
+        TEST_CHECK(NearMatrix(product, matrix * bMatrix));
+
+        Vec4 point(1.f, -2.f, 3.f, 1.f);
+        const Vec4 rotated = q.Rotate(point);
+        point.TransformPoint(matrix);
+        TEST_CHECK(Near(rotated.x, point.x) && Near(rotated.y, point.y) && Near(rotated.z, point.z));
+    }
+}
+
+static void TestSlerp()
+{
+    for (size_t i = 0; i < 32; i++)
+    {
+        const Quat a = GetTestRotation(i);
+        const Quat b = GetTestRotation(i + 5);
+        TEST_CHECK(NearRotation(Slerp(a, b, 0.f), a));
+        TEST_CHECK(NearRotation(Slerp(a, b, 1.f), b));
+
+        // constant angular speed along the shortest path: a quarter of the way is a quarter of the angle
+        const float dot = fabsf(a.x * b.x + a.y * b.y + a.z * b.z + a.w * b.w);
+        const float angle = acosf(fminf(dot, 1.f));
+        const Quat quarter = Slerp(a, b, 0.25f);
+        const float quarterDot = fabsf(a.x * quarter.x + a.y * quarter.y + a.z * quarter.z + a.w * quarter.w);
+        TEST_CHECK(fabsf(acosf(fminf(quarterDot, 1.f)) - angle * 0.25f) < 1e-3f);
+        TEST_CHECK(Near(quarter.x * quarter.x + quarter.y * quarter.y + quarter.z * quarter.z + quarter.w * quarter.w, 1.f));
+
+        // -b is the same rotation, the path doesn't change
+        const Quat negated = { -b.x, -b.y, -b.z, -b.w };
+        TEST_CHECK(NearRotation(Slerp(a, negated, 0.25f), quarter));
+    }
+
+    // close rotations take the normalized lerp path
+    const Quat a = Quat::RotationAxis(Vec4(0.f, 1.f, 0.f), 0.5f);
+    const Quat b = Quat::RotationAxis(Vec4(0.f, 1.f, 0.f), 0.51f);
+    TEST_CHECK(NearRotation(Slerp(a, b, 0.5f), Quat::RotationAxis(Vec4(0.f, 1.f, 0.f), 0.505f)));
+    TEST_CHECK(NearRotation(Slerp(a, a, 0.5f), a));
+}
+
+static void TestComposition()
+{
+    for (size_t i = 0; i < 32; i++)
+    {
+        // exact when the second scale is uniform
+        const Transform a = GetTestTransform(i, (i & 1) != 0);
+        const Transform b = GetTestTransform(i + 3, true);
+        TEST_CHECK(NearMatrix(GetMatrix(a), GetTRSMatrix(a)));
+        TEST_CHECK(NearMatrix(GetMatrix(a * b), GetMatrix(a) * GetMatrix(b)));
+
+        Vec4 point(1.f, -2.f, 3.f, 1.f);
+        const Vec4 transformed = a.TransformPoint(point);
+        point.TransformPoint(GetMatrix(a));
+        TEST_CHECK(Near(transformed.x, point.x) && Near(transformed.y, point.y) && Near(transformed.z, point.z));
+
+        Mat4x4 expected;
+        expected.Inverse(GetMatrix(b));
+        TEST_CHECK(NearMatrix(GetMatrix(b.Inverse()), expected));
+        Mat4x4 identity;
+        identity.Identity();
+        TEST_CHECK(NearMatrix(GetMatrix(b * b.Inverse()), identity));
+    }
+
+    // Lerp ends
+    const Transform a = GetTestTransform(1, false);
+    const Transform b = GetTestTransform(2, false);
+    TEST_CHECK(NearMatrix(GetMatrix(Lerp(a, b, 0.f)), GetMatrix(a)));
+    TEST_CHECK(NearMatrix(GetMatrix(Lerp(a, b, 1.f)), GetMatrix(b)));
+}
+
+static void TestTransformsToMatrices()
+{
+    // split over several worker chunks
+    for (size_t count : { size_t(0), size_t(5), size_t(1024 * 2 + 3) })
+    {
+        std::vector<Transform> transforms(count);
+        for (size_t i = 0; i < count; i++)
+        {
+            transforms[i] = GetTestTransform(i, (i % 3) != 0);
+        }
+        std::vector<Mat4x4> matrices(count);
+        TransformsToMatrices(transforms.data(), matrices.data(), count);
+        bool match = true;
+        for (size_t i = 0; i < count && match; i++)
+        {
+            match = NearMatrix(matrices[i], GetTRSMatrix(transforms[i]));
+        }
+        TEST_CHECK(match);
+    }
+}
+
+static void TestConcatenateHierarchy()
+{
+    static const size_t Count = 200;
+    std::vector<Transform> locals(Count);
+    std::vector<int> parents(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        // a few roots, chains and siblings. Uniform scales: the transform concatenation is exact
+        locals[i] = GetTestTransform(i, true);
+        locals[i].mScale = { 1.f + 0.01f * float(i % 5), 1.f + 0.01f * float(i % 5), 1.f + 0.01f * float(i % 5) };
+        parents[i] = (i % 17) ? int((i * 7) % i) : -1;
+    }
+
+    std::vector<Mat4x4> expected(Count);
+    for (size_t i = 0; i < Count; i++)
+    {
+        expected[i] = (parents[i] >= 0) ? GetTRSMatrix(locals[i]) * expected[parents[i]] : GetTRSMatrix(locals[i]);
+    }
+
+    std::vector<Mat4x4> matrices(Count);
+    ConcatenateHierarchy(locals.data(), parents.data(), matrices.data(), Count);
+    std::vector<Transform> transforms(Count);
+    ConcatenateHierarchy(locals.data(), parents.data(), transforms.data(), Count);
+    bool match = true;
+    for (size_t i = 0; i < Count && match; i++)
+    {
+        match = NearMatrix(matrices[i], expected[i]) && NearMatrix(GetMatrix(transforms[i]), expected[i]);
+    }
+    TEST_CHECK(match);
+}
+
+int main(int, char**)
+{
+    TEST_RUN(TestQuat);
+    TEST_RUN(TestSlerp);
+    TEST_RUN(TestComposition);
+    TEST_RUN(TestTransformsToMatrices);
+    TEST_RUN(TestConcatenateHierarchy);
+    return TestResult();
+}
@@ -0,0 +1,150 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#include <math.h>
+#include <stdint.h>
+#include <string.h>
+#include <limits.h>
+#include "Utils.h"
+#include "TestUtils.h"
+
+// ParseFloat must give strtof results bit for bit
+static bool ParsesLikeStrtof(const char* text)
+{
+    float value = -123.f;
+    const char* last = text + strlen(text);
+    const char* end = ParseFloat(text, last, value);
+    char* expectedEnd;
+    const float expected = strtof(text, &expectedEnd);
+    const bool match = (end == expectedEnd) &&
+                       ((isnan(value) && isnan(expected)) || !memcmp(&value, &expected, sizeof(float)));
+    if (!match)
+    {
+        fprintf(stderr, "  %s: %.9g, expected %.9g\n", text, value, expected);
+    }
+    return match;
+}
+
+static void TestParseFloatEdgeCases()
+{
+    static const char* texts[] = {
+        "0", "-0", "+1", "-1.5", "1e10", "1E-3", "1e+2", "2.5e", "3.e2", ".5", "-.25e1", "000123.4500",
+        "inf", "-Infinity", "INF", "nan", "NaN",
+        // double rounding through double arithmetic gave 1 ulp off
+        "7.038531e-26",
+        // overflow, underflow, subnormals and float limits
+        "1e39", "-1e39", "3.4028235e38", "3.4028236e38", "1e-46", "1e-40", "1.17549435e-38", "1.4e-45",
+        // more digits than a 64 bits mantissa
+        "1.00000000000000000000000000000001", "123456789012345678901234567890", "0.000000000000000000000000000001",
+        // exactly between two floats, and next to it
+        "16777217", "16777217.000000001", "16777216.999999999", "0.1", "0.2", "0.3",
+    };
+    for (auto text : texts)
+    {
+        TEST_CHECK(ParsesLikeStrtof(text));
+    }
+
+    // no digits: nothing read, value unchanged
+    static const char* invalidTexts[] = { "", "-", "+", ".", "e5", "-e5", "abc", ".e1" };
+    for (auto text : invalidTexts)
+    {
+        float value = 42.f;
+        const char* last = text + strlen(text);
+        TEST_CHECK(ParseFloat(text, last, value) == text && value == 42.f);
+    }
+
+    // the range end is honored
+    float value = 0.f;
+    const char* text = "12345";
+    TEST_CHECK(ParseFloat(text, text + 3, value) == text + 3 && value == 123.f);
+}
+
+static void TestParseFloatRandom()
+{
+    // random bit patterns printed with several precisions
+    static const char* formats[] = { "%.9g", "%.6e", "%.8g", "%.3f", "%.17g", "%.12e" };
+    uint32_t state = 12345;
+    int mismatches = 0;
+    for (int i = 0; i < 200000; i++)
+    {
+        state = state * 1664525u + 1013904223u;
+        float source;
+        memcpy(&source, &state, sizeof(float));
+        if (isnan(source) || isinf(source))
+        {
+            continue;
+        }
+        char text[512];
+        snprintf(text, sizeof(text), formats[i % 6], double(source));
+        mismatches += ParsesLikeStrtof(text) ? 0 : 1;
+    }
+    TEST_CHECK(mismatches == 0);
+}
+
+static void TestParseInt()
+{
+    struct IntCase
+    {
+        const char* mText;
+        int mValue;
+        size_t mLength;
+    };
+    static const IntCase cases[] = {
+        { "0", 0, 1 },
+        { "-0", 0, 2 },
+        { "+12", 12, 3 },
+        { "-345", -345, 4 },
+        { "12abc", 12, 2 },
+        { "007", 7, 3 },
+        { "2147483647", INT_MAX, 10 },
+        { "-2147483648", INT_MIN, 11 },
+        // clamped
+        { "2147483648", INT_MAX, 10 },
+        { "-2147483649", INT_MIN, 11 },
+        { "99999999999999999999999", INT_MAX, 23 },
+        { "1.5", 1, 1 },
+    };
+    for (auto& intCase : cases)
+    {
+        int value = -1;
+        const char* last = intCase.mText + strlen(intCase.mText);
+        const char* end = ParseInt(intCase.mText, last, value);
+        TEST_CHECK(end == intCase.mText + intCase.mLength && value == intCase.mValue);
+    }
+    static const char* invalidTexts[] = { "", "-", "+", "abc", " 1", ".5" };
+    for (auto text : invalidTexts)
+    {
+        int value = 42;
+        TEST_CHECK(ParseInt(text, text + strlen(text), value) == text && value == 42);
+    }
+}
+
+int main(int, char**)
+{
+    TEST_RUN(TestParseFloatEdgeCases);
+    TEST_RUN(TestParseFloatRandom);
+    TEST_RUN(TestParseInt);
+    return TestResult();
+}
@@ -0,0 +1,282 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+// Build step: turns the node library into constexpr parameter layouts.
+// Types are qualified in the output so node and parameter identifiers can't hide them.
+// usage: NodeLayoutGenerator <output header> [node definitions.json ...]
+
+#include <stdio.h>
+#include <set>
+#include <map>
+#include <string>
+#include <sstream>
+#include <fstream>
+#include <iterator>
+#include "MetaNodes.h"
+
+static const char* GetParameterCppType(ConTypes paramType)
+{
+    switch (paramType)
+    {
+    case Con_Angle:
+    case Con_Float:
+        return "float";
+    case Con_Angle2:
+    case Con_Float2:
+        return "::Vec2";
+    case Con_Angle3:
+    case Con_Float3:
+        return "::Vec3";
+    case Con_Angle4:
+    case Con_Color4:
+    case Con_Float4:
+        return "::Vec4";
+    case Con_Ramp:
+        return "::Vec2[8]";
+    case Con_Ramp4:
+        return "::Vec4[8]";
+    case Con_Enum:
+    case Con_Int:
+    case Con_Bool:
+    case Con_Multiplexer:
+        return "int";
+    case Con_Int2:
+        return "::iVec2";
+    case Con_FilenameRead:
+    case Con_FilenameWrite:
+        return "char[1024]";
+    case Con_Camera:
+        return "::Camera";
+    default:
+        // no storage or no fixed type: only reachable through the dynamic path
+        return nullptr;
+    }
+}
+
+static std::string MakeIdentifier(const std::string& name)
+{
+    std::string res;
+    for (char c : name)
+    {
+        const bool valid = (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9') || c == '_';
+        res += valid ? c : '_';
+    }
+    if (res.empty() || (res[0] >= '0' && res[0] <= '9'))
+    {
+        res = "_" + res;
+    }
+    return res;
+}
+
+static const char* CppKeywords[] = {
+    "alignas", "alignof", "and", "and_eq", "asm", "auto", "bitand", "bitor", "bool", "break", "case", "catch",
+    "char", "char16_t", "char32_t", "class", "compl", "const", "constexpr", "const_cast", "continue", "decltype",
+    "default", "delete", "do", "double", "dynamic_cast", "else", "enum", "explicit", "export", "extern", "false",
+    "float", "for", "friend", "goto", "if", "inline", "int", "long", "mutable", "namespace", "new", "noexcept",
+    "not", "not_eq", "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "register",
+    "reinterpret_cast", "return", "short", "signed", "sizeof", "static", "static_assert", "static_cast", "struct",
+    "switch", "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid", "typename", "union",
+    "unsigned", "using", "virtual", "void", "volatile", "wchar_t", "while", "xor", "xor_eq",
+};
+
+// members of the generated structs and names of the namespace
+static const char* NodeReservedIdentifiers[] = { "NodeLayouts", "NodeCount", "NodeName", "NodeParametersSize" };
+static const char* ParameterReservedIdentifiers[] = { "NodeName", "NodeParametersSize", "Node", "Type", "Index",
+                                                      "Offset", "ParameterType" };
+
+// MakeIdentifier that never returns a keyword
+static std::string MakeSafeIdentifier(const std::string& name)
+{
+    std::string res = MakeIdentifier(name);
+    for (auto keyword : CppKeywords)
+    {
+        if (res == keyword)
+        {
+            return res + "_";
+        }
+    }
+    return res;
+}
+
+template<size_t count> static void AddIdentifiers(std::set<std::string>& identifiers, const char* (&names)[count])
+{
+    identifiers.insert(names, names + count);
+}
+
+static std::string EscapeString(const std::string& str)
+{
+    std::string res;
+    for (char c : str)
+    {
+        if (c == '"' || c == '\\')
+        {
+            res += '\\';
+        }
+        res += c;
+    }
+    return res;
+}
+
+static void WriteNode(std::ostringstream& out, const MetaNode& node, const std::string& nodeIdentifier)
+{
+    out << "    struct " << nodeIdentifier << "\n";
+    out << "    {\n";
+    out << "        static const char* NodeName() { return \"" << EscapeString(node.mName) << "\"; }\n";
+    out << "        static constexpr ::size_t NodeParametersSize = " << node.mParametersSize << ";\n";
+
+    // parameters keep their identifier when they can, the ones colliding get a suffix afterwards
+    std::set<std::string> usedIdentifiers;
+    AddIdentifiers(usedIdentifiers, ParameterReservedIdentifiers);
+    usedIdentifiers.insert(nodeIdentifier);
+    std::vector<std::string> identifiers(node.mParams.size());
+    for (size_t i = 0; i < node.mParams.size(); i++)
+    {
+        const std::string identifier = MakeSafeIdentifier(node.mParams[i].mName);
+        if (GetParameterCppType(node.mParams[i].mType) && usedIdentifiers.insert(identifier).second)
+        {
+            identifiers[i] = identifier;
+        }
+    }
+    for (size_t i = 0; i < node.mParams.size(); i++)
+    {
+        if (!identifiers[i].empty() || !GetParameterCppType(node.mParams[i].mType))
+        {
+            continue;
+        }
+        std::string identifier = MakeSafeIdentifier(node.mParams[i].mName) + "_" + std::to_string(i);
+        while (!usedIdentifiers.insert(identifier).second)
+        {
+            identifier += "_";
+        }
+        identifiers[i] = identifier;
+    }
+
+    for (size_t i = 0; i < node.mParams.size(); i++)
+    {
+        const MetaParameter& param = node.mParams[i];
+        const char* cppType = GetParameterCppType(param.mType);
+        if (!cppType)
+        {
+            continue;
+        }
+        const MetaParameterLayout& layout = node.mParametersLayout[i];
+        out << "        struct " << identifiers[i] << "\n";
+        out << "        {\n";
+        out << "            using Node = NodeLayouts::" << nodeIdentifier << ";\n";
+        out << "            using Type = " << cppType << ";\n";
+        out << "            static constexpr ::uint32_t Index = " << i << ";\n";
+        out << "            static constexpr ::uint32_t Offset = " << layout.mOffset << ";\n";
+        out << "            static constexpr ::ConTypes ParameterType = " << "::Con_" << GetParameterTypeName(param.mType) << ";\n";
+        out << "        };\n";
+    }
+    out << "    };\n";
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        fprintf(stderr, "usage: %s <output header> [node definitions.json ...]\n", argv[0]);
+        return 1;
+    }
+
+    std::ostringstream out;
+    out << "// Generated by NodeLayoutGenerator from the node library. Do not edit.\n";
+    out << "#pragma once\n\n";
+    out << "#include <stddef.h>\n";
+    out << "#include <stdint.h>\n";
+    out << "#include \"MetaNodes.h\"\n";
+    out << "#include \"Camera.h\"\n\n";
+    out << "namespace NodeLayouts\n";
+    out << "{\n";
+
+    // same rule as gMetaNodesIndices: the last definition of a name wins
+    std::vector<MetaNode> libraryNodes;
+    std::map<std::string, size_t> nodeIndices;
+    for (int i = 2; i < argc; i++)
+    {
+        std::vector<MetaNode> metaNodes = ReadMetaNodes(argv[i]);
+        for (MetaNode& node : metaNodes)
+        {
+            auto iter = nodeIndices.find(node.mName);
+            if (iter != nodeIndices.end())
+            {
+                libraryNodes[iter->second] = node;
+                continue;
+            }
+            nodeIndices[node.mName] = libraryNodes.size();
+            libraryNodes.emplace_back(node);
+        }
+    }
+
+    // distinct names can give the same identifier ("a-b" and "a_b"), one would hide the other
+    std::set<std::string> reservedIdentifiers;
+    AddIdentifiers(reservedIdentifiers, NodeReservedIdentifiers);
+    std::map<std::string, const MetaNode*> nodeIdentifiers;
+    for (const MetaNode& node : libraryNodes)
+    {
+        std::string identifier = MakeSafeIdentifier(node.mName);
+        if (reservedIdentifiers.count(identifier))
+        {
+            identifier += "_";
+        }
+        auto iter = nodeIdentifiers.find(identifier);
+        if (iter != nodeIdentifiers.end())
+        {
+            fprintf(stderr,
+                    "Nodes %s and %s have the same identifier %s\n",
+                    iter->second->mName.c_str(),
+                    node.mName.c_str(),
+                    identifier.c_str());
+            return 1;
+        }
+        nodeIdentifiers[identifier] = &node;
+        WriteNode(out, node, identifier);
+    }
+    out << "    static constexpr ::size_t NodeCount = " << libraryNodes.size() << ";\n";
+    out << "}\n";
+
+    // only touch the header when it changes to avoid needless rebuilds
+    const std::string content = out.str();
+    {
+        std::ifstream previous(argv[1]);
+        if (previous.good())
+        {
+            std::string previousContent((std::istreambuf_iterator<char>(previous)), std::istreambuf_iterator<char>());
+            if (previousContent == content)
+            {
+                return 0;
+            }
+        }
+    }
+    std::ofstream header(argv[1], std::ios::binary);
+    if (!header.good())
+    {
+        fprintf(stderr, "Unable to write %s\n", argv[1]);
+        return 1;
+    }
+    header << content;
+    return 0;
+}
@@ -0,0 +1,102 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+
+// Converts a binary trace file (see Trace.h) to Chrome trace JSON.
+// usage: TraceDecoder <trace file> <output.json>
+
+#include <stdio.h>
+#include <inttypes.h>
+#include "Trace.h"
+#include "MappedFile.h"
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        fprintf(stderr, "usage: %s <trace file> <output.json>\n", argv[0]);
+        return 1;
+    }
+
+    MappedFile file;
+    if (!file.Open(argv[1]))
+    {
+        fprintf(stderr, "Unable to read %s\n", argv[1]);
+        return 1;
+    }
+    const TraceFileHeader* header = GetTraceFileHeader(file.Data(), file.Size());
+    if (!header)
+    {
+        fprintf(stderr, "%s is not a valid trace file\n", argv[1]);
+        return 1;
+    }
+    std::vector<const TraceEvent*> events;
+    const uint64_t skipped = GetTraceEvents(header, events);
+    const uint64_t writePosition = header->mWritePosition.load();
+    const uint64_t overwritten = (writePosition > header->mEventCapacity) ? writePosition - header->mEventCapacity : 0;
+
+    FILE* fp = fopen(argv[2], "wt");
+    if (!fp)
+    {
+        fprintf(stderr, "Unable to write %s\n", argv[2]);
+        return 1;
+    }
+
+    fprintf(fp, "{\"traceEvents\":[\n");
+    for (size_t index = 0; index < events.size(); index++)
+    {
+        const TraceEvent& event = *events[index];
+        // Chrome trace times are in microseconds
+        fprintf(fp,
+                "%s{\"name\":\"%s\",\"cat\":\"gemoni\",\"ph\":\"%s\",\"ts\":%.3f,",
+                index ? ",\n" : "",
+                GetTraceEventName(event.mId),
+                event.mDuration ? "X" : "i",
+                double(event.mTimestamp) / 1000.0);
+        if (event.mDuration)
+        {
+            fprintf(fp, "\"dur\":%.3f,", double(event.mDuration) / 1000.0);
+        }
+        else
+        {
+            fprintf(fp, "\"s\":\"t\",");
+        }
+        fprintf(fp,
+                "\"pid\":0,\"tid\":%d,\"args\":{\"node\":%d,\"parameter\":%d}}",
+                int(event.mThread),
+                int(event.mNodeIndex),
+                int(event.mParameterIndex));
+    }
+    fprintf(fp,
+            "\n],\"displayTimeUnit\":\"ms\",\"otherData\":{\"startTime\":\"%" PRIu64 "\",\"eventCount\":\"%" PRIu64
+            "\",\"overwritten\":\"%" PRIu64 "\",\"skipped\":\"%" PRIu64 "\"}}\n",
+            header->mStartTime,
+            writePosition,
+            overwritten,
+            skipped);
+    fclose(fp);
+    printf("%zu events written to %s\n", events.size(), argv[2]);
+    return 0;
+}
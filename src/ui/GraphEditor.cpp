@@ -29,10 +29,11 @@
 #include <vector>
 #include <float.h>
 #include <array>
-#include <set>
 #include <map>
+#include <unordered_map>
 #include <algorithm>
 #include "GraphEditor.h"
+#include "NodeSelection.h"
 
 static inline float Distance(ImVec2& a, ImVec2& b)
 {
@@ -66,7 +67,220 @@ ImRect GetNodeRect(const GraphEditorDelegate::Node& node, float factor)
     return ImRect(node.mRect.Min * factor, node.mRect.Min * factor + Size);
 }
 
+void GraphChangeJournal::Record(ChangeType type, uint32_t index)
+{
+    if (mChanges.empty())
+    {
+        mChanges.resize(Capacity);
+    }
+    mChanges[mGeneration % Capacity] = { type, index };
+    mGeneration++;
+    if (type == NodeAdded || type == NodeRemoved || type == NodeMoved)
+    {
+        mNodeGeneration++;
+    }
+    else
+    {
+        mLinkGeneration++;
+    }
+}
+
+void GraphChangeJournal::Reset()
+{
+    mGeneration++;
+    mResetGeneration = mGeneration;
+    mNodeGeneration++;
+    mLinkGeneration++;
+}
+
+bool GraphChangeJournal::GetChanges(uint64_t generation, std::vector<Change>& changes) const
+{
+    if (generation < mResetGeneration || generation > mGeneration || mGeneration - generation > Capacity)
+    {
+        return false;
+    }
+    for (uint64_t change = generation; change < mGeneration; change++)
+    {
+        changes.push_back(mChanges[change % Capacity]);
+    }
+    return true;
+}
+
+// Uniform grid of world space rectangles. Items are small integers (node or link indices).
+// Items covering too many cells are kept aside and tested on every query.
+struct GridIndex
+{
+    void Clear()
+    {
+        mCells.clear();
+        mItems.clear();
+        mLargeItems.clear();
+    }
+
+    void Insert(uint32_t item, const ImRect& rect)
+    {
+        if (item >= mItems.size())
+        {
+            mItems.resize(item + 1);
+        }
+        Item& entry = mItems[item];
+        if (entry.mbIndexed)
+        {
+            Remove(item);
+        }
+        entry.mRect = rect;
+        entry.mbIndexed = true;
+        entry.mCells = GetCellRange(rect);
+        entry.mbLarge = entry.mCells.GetCount() > MaxItemCells;
+        if (entry.mbLarge)
+        {
+            mLargeItems.push_back(item);
+            return;
+        }
+        for (int y = entry.mCells.mMinY; y <= entry.mCells.mMaxY; y++)
+        {
+            for (int x = entry.mCells.mMinX; x <= entry.mCells.mMaxX; x++)
+            {
+                mCells[CellKey(x, y)].push_back(item);
+            }
+        }
+    }
+
+    void Remove(uint32_t item)
+    {
+        if (item >= mItems.size() || !mItems[item].mbIndexed)
+        {
+            return;
+        }
+        Item& entry = mItems[item];
+        entry.mbIndexed = false;
+        if (entry.mbLarge)
+        {
+            RemoveFrom(mLargeItems, item);
+            return;
+        }
+        for (int y = entry.mCells.mMinY; y <= entry.mCells.mMaxY; y++)
+        {
+            for (int x = entry.mCells.mMinX; x <= entry.mCells.mMaxX; x++)
+            {
+                auto iter = mCells.find(CellKey(x, y));
+                if (iter != mCells.end())
+                {
+                    RemoveFrom(iter->second, item);
+                    if (iter->second.empty())
+                    {
+                        mCells.erase(iter);
+                    }
+                }
+            }
+        }
+    }
+
+    // Appends the items overlapping rect, sorted and unique
+    void Query(const ImRect& rect, std::vector<uint32_t>& items)
+    {
+        const size_t first = items.size();
+        const CellRange range = GetCellRange(rect);
+        if (range.GetCount() > int64_t(mCells.size()))
+        {
+            // view larger than the populated area: walk the populated cells
+            for (auto& cell : mCells)
+            {
+                const int x = int(int32_t(cell.first >> 32));
+                const int y = int(int32_t(cell.first & 0xFFFFFFFF));
+                if (x >= range.mMinX && x <= range.mMaxX && y >= range.mMinY && y <= range.mMaxY)
+                {
+                    AddOverlapping(cell.second, rect, items);
+                }
+            }
+        }
+        else
+        {
+            for (int y = range.mMinY; y <= range.mMaxY; y++)
+            {
+                for (int x = range.mMinX; x <= range.mMaxX; x++)
+                {
+                    auto iter = mCells.find(CellKey(x, y));
+                    if (iter != mCells.end())
+                    {
+                        AddOverlapping(iter->second, rect, items);
+                    }
+                }
+            }
+        }
+        AddOverlapping(mLargeItems, rect, items);
+        std::sort(items.begin() + first, items.end());
+        items.erase(std::unique(items.begin() + first, items.end()), items.end());
+    }
+
+private:
+    static constexpr float CellSize = 512.f;
+    static const int MaxItemCells = 64;
+
+    struct CellRange
+    {
+        int mMinX, mMinY, mMaxX, mMaxY;
+
+        int64_t GetCount() const
+        {
+            return int64_t(mMaxX - mMinX + 1) * int64_t(mMaxY - mMinY + 1);
+        }
+    };
+
+    struct Item
+    {
+        ImRect mRect;
+        CellRange mCells;
+        bool mbIndexed{ false };
+        bool mbLarge{ false };
+    };
+
+    static uint64_t CellKey(int x, int y)
+    {
+        return (uint64_t(uint32_t(x)) << 32) | uint32_t(y);
+    }
+
+    static int GetCell(float v)
+    {
+        const float limit = float(1 << 20);
+        return int(ImClamp(floorf(v / CellSize), -limit, limit));
+    }
+
+    static CellRange GetCellRange(const ImRect& rect)
+    {
+        return { GetCell(rect.Min.x), GetCell(rect.Min.y), GetCell(rect.Max.x), GetCell(rect.Max.y) };
+    }
+
+    static void RemoveFrom(std::vector<uint32_t>& items, uint32_t item)
+    {
+        auto iter = std::find(items.begin(), items.end(), item);
+        if (iter != items.end())
+        {
+            *iter = items.back();
+            items.pop_back();
+        }
+    }
+
+    void AddOverlapping(const std::vector<uint32_t>& candidates, const ImRect& rect, std::vector<uint32_t>& items) const
+    {
+        for (auto item : candidates)
+        {
+            if (mItems[item].mRect.Overlaps(rect))
+            {
+                items.push_back(item);
+            }
+        }
+    }
+
+    std::unordered_map<uint64_t, std::vector<uint32_t>> mCells;
+    std::vector<Item> mItems;
+    std::vector<uint32_t> mLargeItems;
+};
+
 static const float NODE_SLOT_RADIUS = 8.0f;
+// below this zoom factor, nodes are plain quads and links straight segments. Nodes near the
+// mouse keep their details and ImGui items so they can still be hovered, moved and linked.
+static const float LOD_FACTOR = 0.5f;
 static const ImVec2 NODE_WINDOW_PADDING(8.0f, 8.0f);
 
 static ImVec2 editingNodeSource;
@@ -76,7 +290,7 @@ float factor = 1.0f;
 float factorTarget = 1.0f;
 ImVec2 captureOffset;
 static bool inTransaction = false;
-static std::set<int> selectedNodes;
+static NodeSelection selectedNodes;
 ImVec2 movingNodesOffset;
 enum NodeOperation
 {
@@ -89,51 +303,430 @@ enum NodeOperation
 };
 NodeOperation nodeOperation = NO_None;
 
-void GraphEditorClear()
+// orthogonal routing between an output and an input slot, returns the point count
+static int RouteLink(const ImVec2 p1, const ImVec2 p2, const float factor, std::array<ImVec2, 6>& pts)
 {
-    nodeOperation = NO_None;
-    factor = 1.0f;
-    factorTarget = 1.0f;
-    selectedNodes.clear();
+    int ptCount = 0;
+    ImVec2 dif = p2 - p1;
+
+    ImVec2 p1a, p1b;
+    const float limitx = 12.f * factor;
+    if (dif.x < limitx)
+    {
+        ImVec2 p10 = p1 + ImVec2(limitx, 0.f);
+        ImVec2 p20 = p2 - ImVec2(limitx, 0.f);
+
+        dif = p20 - p10;
+        p1a = p10 + ImVec2(0.f, dif.y * 0.5f);
+        p1b = p1a + ImVec2(dif.x, 0.f);
+
+        pts = {p1, p10, p1a, p1b, p20, p2};
+        ptCount = 6;
+    }
+    else
+    {
+        if (fabsf(dif.y) < 1.f)
+        {
+            pts = {p1, (p1 + p2) * 0.5f, p2};
+            ptCount = 3;
+        }
+        else
+        {
+            if (fabsf(dif.y) < 10.f)
+            {
+                if (fabsf(dif.x) > fabsf(dif.y))
+                {
+                    p1a = p1 + ImVec2(fabsf(fabsf(dif.x) - fabsf(dif.y)) * 0.5f * sign(dif.x), 0.f);
+                    p1b = p1a + ImVec2(fabsf(dif.y) * sign(dif.x), dif.y);
+                }
+                else
+                {
+                    p1a = p1 + ImVec2(0.f, fabsf(fabsf(dif.y) - fabsf(dif.x)) * 0.5f * sign(dif.y));
+                    p1b = p1a + ImVec2(dif.x, fabsf(dif.x) * sign(dif.y));
+                }
+            }
+            else
+            {
+                if (fabsf(dif.x) > fabsf(dif.y))
+                {
+                    float d = fabsf(dif.y) * sign(dif.x) * 0.5f;
+                    p1a = p1 + ImVec2(d, dif.y * 0.5f);
+                    p1b = p1a + ImVec2(fabsf(fabsf(dif.x) - fabsf(d) * 2.f) * sign(dif.x), 0.f);
+                }
+                else
+                {
+                    float d = fabsf(dif.x) * sign(dif.y) * 0.5f;
+                    p1a = p1 + ImVec2(dif.x * 0.5f, d);
+                    p1b = p1a + ImVec2(0.f, fabsf(fabsf(dif.y) - fabsf(d) * 2.f) * sign(dif.y));
+                }
+            }
+            pts = {p1, p1a, p1b, p2};
+            ptCount = 4;
+        }
+    }
+    return ptCount;
 }
 
-std::vector<NodeIndex> GetSelectedNodes()
+// Routed and tessellated link, outline and fill in a single mesh, relative to the canvas offset.
+// Rebuilt when an end node moves, the zoom or the link color change.
+struct LinkGeometry
 {
-    std::vector<NodeIndex> res;
-    for (auto selectedNodeIndex : selectedNodes)
+    GraphEditorDelegate::Link mLink;
+    ImRect mInputNodeRect;
+    ImRect mOutputNodeRect;
+    float mFactor{ 0.f };
+    uint32_t mColor{ 0 };
+    bool mbHighlight{ false };
+    bool mbValid{ false };
+    ImVec2 mWhitePixel;
+    int mDrawListFlags{ 0 };
+    std::vector<ImDrawVert> mVertices;
+    std::vector<ImDrawIdx> mIndices;
+
+    bool IsValid(const GraphEditorDelegate::Link& link,
+                 const GraphEditorDelegate::Node& inputNode,
+                 const GraphEditorDelegate::Node& outputNode,
+                 const float factor,
+                 const uint32_t color,
+                 const bool highlight) const
     {
-        res.push_back(selectedNodeIndex);
+        const ImDrawListSharedData* sharedData = ImGui::GetDrawListSharedData();
+        return mbValid && !memcmp(&mLink, &link, sizeof(link)) && mFactor == factor && mColor == color &&
+               mbHighlight == highlight && !memcmp(&mInputNodeRect, &inputNode.mRect, sizeof(ImRect)) &&
+               !memcmp(&mOutputNodeRect, &outputNode.mRect, sizeof(ImRect)) &&
+               mWhitePixel.x == sharedData->TexUvWhitePixel.x && mWhitePixel.y == sharedData->TexUvWhitePixel.y &&
+               mDrawListFlags == sharedData->InitialFlags;
     }
-    return res;
+
+    void Draw(ImDrawList* drawList, const ImVec2 offset) const
+    {
+        if (mIndices.empty())
+        {
+            return;
+        }
+        drawList->PrimReserve(int(mIndices.size()), int(mVertices.size()));
+        const unsigned int base = drawList->_VtxCurrentIdx;
+        for (const auto& vertex : mVertices)
+        {
+            drawList->_VtxWritePtr->pos = vertex.pos + offset;
+            drawList->_VtxWritePtr->uv = vertex.uv;
+            drawList->_VtxWritePtr->col = vertex.col;
+            drawList->_VtxWritePtr++;
+        }
+        for (auto index : mIndices)
+        {
+            *drawList->_IdxWritePtr++ = ImDrawIdx(base + index);
+        }
+        drawList->_VtxCurrentIdx += (unsigned int)mVertices.size();
+    }
+};
+
+static std::vector<LinkGeometry> linkGeometries;
+
+static void BuildLinkGeometry(LinkGeometry& geometry,
+                              const GraphEditorDelegate::Link& link,
+                              const GraphEditorDelegate::Node& inputNode,
+                              const GraphEditorDelegate::Node& outputNode,
+                              const float factor,
+                              const uint32_t color,
+                              const bool highlight)
+{
+    // tessellated by ImGui in a scratch draw list, then kept
+    static ImDrawList* scratch = nullptr;
+    ImDrawListSharedData* sharedData = ImGui::GetDrawListSharedData();
+    if (!scratch || scratch->_Data != sharedData)
+    {
+        IM_DELETE(scratch);
+        scratch = IM_NEW(ImDrawList)(sharedData);
+    }
+    scratch->_ResetForNewFrame();
+    scratch->PushClipRectFullScreen();
+    scratch->PushTextureID(ImGui::GetIO().Fonts->TexID);
+
+    const ImVec2 p1 = GetOutputSlotPos(inputNode, link.mInputSlotIndex, factor);
+    const ImVec2 p2 = GetInputSlotPos(outputNode, link.mOutputSlotIndex, factor);
+    std::array<ImVec2, 6> pts;
+    const int ptCount = RouteLink(p1, p2, factor, pts);
+    const float highLightFactor = factor * (highlight ? 2.0f : 1.f);
+    scratch->AddPolyline(pts.data(), ptCount, 0xFF000000, false, 7.5f * highLightFactor);
+    scratch->AddPolyline(pts.data(), ptCount, color, false, 5.f * highLightFactor);
+
+    geometry.mVertices.assign(scratch->VtxBuffer.begin(), scratch->VtxBuffer.end());
+    geometry.mIndices.assign(scratch->IdxBuffer.begin(), scratch->IdxBuffer.end());
+    geometry.mLink = link;
+    geometry.mInputNodeRect = inputNode.mRect;
+    geometry.mOutputNodeRect = outputNode.mRect;
+    geometry.mFactor = factor;
+    geometry.mColor = color;
+    geometry.mbHighlight = highlight;
+    geometry.mWhitePixel = sharedData->TexUvWhitePixel;
+    geometry.mDrawListFlags = sharedData->InitialFlags;
+    geometry.mbValid = true;
 }
 
-void UnSelectNodes()
+// world space index of the delegate nodes and links, kept in sync with the editor operations.
+// Rebuilt when the node or link count changes behind the editor back.
+static GridIndex nodeGrid;
+static GridIndex linkGrid;
+static std::vector<std::vector<uint32_t>> nodeLinks; // links using each node
+// links by (node, slot), for each end of the links
+static std::unordered_map<uint64_t, std::vector<uint32_t>> inputSlotLinks;
+static std::unordered_map<uint64_t, std::vector<uint32_t>> outputSlotLinks;
+static size_t indexedNodeCount = 0;
+static size_t indexedLinkCount = 0;
+static bool nodeIndexDirty = true;
+static bool linkIndexDirty = true;
+// links routing goes a bit outside the node rectangles
+static const float LINK_BOUNDS_MARGIN = 16.f;
+// slot offsets and line widths are in pixels
+static const float VIEW_PIXEL_MARGIN = 32.f;
+
+static void IndexLink(const std::vector<GraphEditorDelegate::Node>& nodes, const GraphEditorDelegate::Link& link, uint32_t linkIndex)
 {
-    selectedNodes.clear();
+    if (size_t(link.mInputNodeIndex) >= nodes.size() || size_t(link.mOutputNodeIndex) >= nodes.size())
+    {
+        return;
+    }
+    ImRect bounds = nodes[link.mInputNodeIndex].mRect;
+    bounds.Add(nodes[link.mOutputNodeIndex].mRect);
+    bounds.Expand(LINK_BOUNDS_MARGIN);
+    linkGrid.Insert(linkIndex, bounds);
 }
 
-bool IsNodeSelected(int nodeIndex)
+static uint64_t SlotKey(int nodeIndex, int slotIndex)
 {
-    return std::find(selectedNodes.begin(), selectedNodes.end(), nodeIndex) != selectedNodes.end();
+    return (uint64_t(uint32_t(nodeIndex)) << 32) | uint32_t(slotIndex);
 }
 
-void SelectNode(int nodeIndex, bool selected)
+static void IndexLinkSlots(const GraphEditorDelegate::Link& link, uint32_t linkIndex)
 {
-    auto iter = std::find(selectedNodes.begin(), selectedNodes.end(), nodeIndex);
-    if (iter != selectedNodes.end())
+    inputSlotLinks[SlotKey(link.mInputNodeIndex, link.mInputSlotIndex)].push_back(linkIndex);
+    outputSlotLinks[SlotKey(link.mOutputNodeIndex, link.mOutputSlotIndex)].push_back(linkIndex);
+}
+
+static const std::vector<uint32_t>* GetSlotLinks(const std::unordered_map<uint64_t, std::vector<uint32_t>>& slotLinks,
+                                                 int nodeIndex,
+                                                 int slotIndex)
+{
+    auto iter = slotLinks.find(SlotKey(nodeIndex, slotIndex));
+    return (iter == slotLinks.end() || iter->second.empty()) ? nullptr : &iter->second;
+}
+
+static void RebuildLinkIndex(GraphEditorDelegate* delegate)
+{
+    const auto& nodes = delegate->GetNodes();
+    const auto& links = delegate->GetLinks();
+    linkGrid.Clear();
+    nodeLinks.clear();
+    nodeLinks.resize(nodes.size());
+    inputSlotLinks.clear();
+    outputSlotLinks.clear();
+    linkGeometries.clear();
+    linkGeometries.resize(links.size());
+    for (size_t linkIndex = 0; linkIndex < links.size(); linkIndex++)
     {
-        if (!selected)
+        const auto& link = links[linkIndex];
+        IndexLink(nodes, link, uint32_t(linkIndex));
+        IndexLinkSlots(link, uint32_t(linkIndex));
+        if (size_t(link.mInputNodeIndex) < nodes.size() && size_t(link.mOutputNodeIndex) < nodes.size())
         {
-            selectedNodes.erase(iter);
+            nodeLinks[link.mInputNodeIndex].push_back(uint32_t(linkIndex));
+            if (link.mOutputNodeIndex != link.mInputNodeIndex)
+            {
+                nodeLinks[link.mOutputNodeIndex].push_back(uint32_t(linkIndex));
+            }
         }
+    }
+    indexedLinkCount = links.size();
+    linkIndexDirty = false;
+}
 
+static void IndexNodes(GraphEditorDelegate* delegate, const std::vector<NodeIndex>& nodeIndices)
+{
+    const auto& nodes = delegate->GetNodes();
+    const auto& links = delegate->GetLinks();
+    nodeLinks.resize(nodes.size());
+    for (auto nodeIndex : nodeIndices)
+    {
+        if (nodeIndex >= nodes.size())
+        {
+            continue;
+        }
+        nodeGrid.Insert(nodeIndex, nodes[nodeIndex].mRect);
+        for (auto linkIndex : nodeLinks[nodeIndex])
+        {
+            IndexLink(nodes, links[linkIndex], linkIndex);
+        }
+    }
+    indexedNodeCount = nodes.size();
+}
+
+static void AppendLinkIndex(GraphEditorDelegate* delegate, uint32_t linkIndex)
+{
+    const auto& nodes = delegate->GetNodes();
+    const auto& link = delegate->GetLinks()[linkIndex];
+    IndexLink(nodes, link, linkIndex);
+    IndexLinkSlots(link, linkIndex);
+    if (size_t(link.mInputNodeIndex) < nodes.size() && size_t(link.mOutputNodeIndex) < nodes.size())
+    {
+        nodeLinks[link.mInputNodeIndex].push_back(linkIndex);
+        if (link.mOutputNodeIndex != link.mInputNodeIndex)
+        {
+            nodeLinks[link.mOutputNodeIndex].push_back(linkIndex);
+        }
+    }
+    linkGeometries.resize(linkIndex + 1);
+    indexedLinkCount = linkIndex + 1;
+}
+
+// replays the delegate journal: moves, appended nodes and links are applied. A link removal
+// rebuilds the link index, a node removal everything.
+static void ApplyChangeJournal(GraphEditorDelegate* delegate)
+{
+    static uint64_t journalGeneration = 0;
+    static std::vector<GraphChangeJournal::Change> changes;
+    const GraphChangeJournal* journal = delegate->GetChangeJournal();
+    if (!journal || journal->GetGeneration() == journalGeneration)
+    {
+        return;
+    }
+    changes.clear();
+    if (nodeIndexDirty || !journal->GetChanges(journalGeneration, changes))
+    {
+        GraphEditorInvalidateSpatialIndex();
+        changes.clear();
+    }
+    journalGeneration = journal->GetGeneration();
+
+    static std::vector<NodeIndex> changedNodes;
+    changedNodes.clear();
+    for (const auto& change : changes)
+    {
+        switch (change.mType)
+        {
+        case GraphChangeJournal::NodeAdded:
+        case GraphChangeJournal::NodeMoved:
+            changedNodes.push_back(change.mIndex);
+            break;
+        case GraphChangeJournal::LinkAdded:
+            if (!linkIndexDirty && change.mIndex == indexedLinkCount && change.mIndex < delegate->GetLinks().size())
+            {
+                // links are usually appended
+                IndexNodes(delegate, changedNodes);
+                changedNodes.clear();
+                AppendLinkIndex(delegate, change.mIndex);
+            }
+            else
+            {
+                linkIndexDirty = true;
+            }
+            break;
+        case GraphChangeJournal::NodeRemoved:
+            GraphEditorInvalidateSpatialIndex();
+            return;
+        case GraphChangeJournal::LinkRemoved:
+            linkIndexDirty = true;
+            break;
+        }
+    }
+    if (!linkIndexDirty)
+    {
+        IndexNodes(delegate, changedNodes);
     }
     else
     {
-        if (selected)
+        // only the nodes here, the links are all reindexed by UpdateSpatialIndex
+        const auto& nodes = delegate->GetNodes();
+        for (auto nodeIndex : changedNodes)
         {
-            selectedNodes.insert(nodeIndex);
+            if (nodeIndex < nodes.size())
+            {
+                nodeGrid.Insert(nodeIndex, nodes[nodeIndex].mRect);
+            }
         }
+        indexedNodeCount = nodes.size();
+    }
+}
+
+static void UpdateSpatialIndex(GraphEditorDelegate* delegate)
+{
+    ApplyChangeJournal(delegate);
+    const auto& nodes = delegate->GetNodes();
+    if (nodeIndexDirty || indexedNodeCount != nodes.size())
+    {
+        nodeGrid.Clear();
+        for (size_t nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+        {
+            nodeGrid.Insert(uint32_t(nodeIndex), nodes[nodeIndex].mRect);
+        }
+        indexedNodeCount = nodes.size();
+        nodeIndexDirty = false;
+        linkIndexDirty = true;
+    }
+    if (linkIndexDirty || indexedLinkCount != delegate->GetLinks().size())
+    {
+        RebuildLinkIndex(delegate);
+    }
+}
+
+// nodes moved or appended by an editor operation, delegates with a journal report them there
+static void UpdateSpatialIndex(GraphEditorDelegate* delegate, const std::vector<NodeIndex>& nodeIndices)
+{
+    if (nodeIndexDirty || linkIndexDirty || delegate->GetChangeJournal())
+    {
+        return;
+    }
+    IndexNodes(delegate, nodeIndices);
+}
+
+// links added or removed by an editor operation, delegates with a journal report them there
+static void UpdateLinkIndex(GraphEditorDelegate* delegate)
+{
+    if (!delegate->GetChangeJournal())
+    {
+        linkIndexDirty = true;
+    }
+}
+
+void GraphEditorInvalidateSpatialIndex()
+{
+    nodeIndexDirty = true;
+    linkIndexDirty = true;
+}
+
+void GraphEditorClear()
+{
+    nodeOperation = NO_None;
+    factor = 1.0f;
+    factorTarget = 1.0f;
+    selectedNodes.Clear();
+    GraphEditorInvalidateSpatialIndex();
+}
+
+// sorted
+std::vector<NodeIndex> GetSelectedNodes()
+{
+    const auto& nodes = selectedNodes.GetNodes();
+    std::vector<NodeIndex> res(nodes.begin(), nodes.end());
+    std::sort(res.begin(), res.end());
+    return res;
+}
+
+void UnSelectNodes()
+{
+    selectedNodes.Clear();
+}
+
+bool IsNodeSelected(int nodeIndex)
+{
+    return nodeIndex >= 0 && selectedNodes.IsSelected(uint32_t(nodeIndex));
+}
+
+void SelectNode(int nodeIndex, bool selected)
+{
+    if (nodeIndex >= 0)
+    {
+        selectedNodes.Select(uint32_t(nodeIndex), selected);
     }
 }
 
@@ -189,11 +782,17 @@ static void DisplayLinks(GraphEditorDelegate* delegate,
                          const ImVec2 offset,
                          const float factor,
                          const ImRect regionRect,
-                         int hoveredNode)
+                         int hoveredNode,
+                         bool lod)
 {
     const auto& links = delegate->GetLinks();
     const auto& nodes = delegate->GetNodes();
-    for (int link_idx = 0; link_idx < links.size(); link_idx++)
+    static std::vector<uint32_t> visibleLinks;
+    visibleLinks.clear();
+    ImRect viewRect((regionRect.Min - offset) / factor, (regionRect.Max - offset) / factor);
+    viewRect.Expand(VIEW_PIXEL_MARGIN / factor);
+    linkGrid.Query(viewRect, visibleLinks);
+    for (auto link_idx : visibleLinks)
     {
         const auto* link = &links[link_idx];
         const auto* node_inp = &nodes[link->mInputNodeIndex];
@@ -237,71 +836,25 @@ static void DisplayLinks(GraphEditorDelegate* delegate,
         drawList->AddLine(p1b, p20, col, 3.f * factor);
         drawList->AddLine(p20,  p2, col, 3.f * factor);
         */
-        std::array<ImVec2, 6> pts;
-        int ptCount = 0;
-        ImVec2 dif = p2 - p1;
-
-        ImVec2 p1a, p1b;
-        const float limitx = 12.f * factor;
-        if (dif.x < limitx)
+        if (lod)
         {
-            ImVec2 p10 = p1 + ImVec2(limitx, 0.f);
-            ImVec2 p20 = p2 - ImVec2(limitx, 0.f);
-
-            dif = p20 - p10;
-            p1a = p10 + ImVec2(0.f, dif.y * 0.5f);
-            p1b = p1a + ImVec2(dif.x, 0.f);
-
-            pts = {p1, p10, p1a, p1b, p20, p2};
-            ptCount = 6;
-        }
-        else
-        {
-            if (fabsf(dif.y) < 1.f)
+            const ImVec2 dir = p2 - p1;
+            const float length = sqrtf(dir.x * dir.x + dir.y * dir.y);
+            if (length > FLT_EPSILON)
             {
-                pts = {p1, (p1 + p2) * 0.5f, p2};
-                ptCount = 3;
-            }
-            else
-            {
-                if (fabsf(dif.y) < 10.f)
-                {
-                    if (fabsf(dif.x) > fabsf(dif.y))
-                    {
-                        p1a = p1 + ImVec2(fabsf(fabsf(dif.x) - fabsf(dif.y)) * 0.5f * sign(dif.x), 0.f);
-                        p1b = p1a + ImVec2(fabsf(dif.y) * sign(dif.x), dif.y);
-                    }
-                    else
-                    {
-                        p1a = p1 + ImVec2(0.f, fabsf(fabsf(dif.y) - fabsf(dif.x)) * 0.5f * sign(dif.y));
-                        p1b = p1a + ImVec2(dif.x, fabsf(dif.x) * sign(dif.y));
-                    }
-                }
-                else
-                {
-                    if (fabsf(dif.x) > fabsf(dif.y))
-                    {
-                        float d = fabsf(dif.y) * sign(dif.x) * 0.5f;
-                        p1a = p1 + ImVec2(d, dif.y * 0.5f);
-                        p1b = p1a + ImVec2(fabsf(fabsf(dif.x) - fabsf(d) * 2.f) * sign(dif.x), 0.f);
-                    }
-                    else
-                    {
-                        float d = fabsf(dif.x) * sign(dif.y) * 0.5f;
-                        p1a = p1 + ImVec2(dif.x * 0.5f, d);
-                        p1b = p1a + ImVec2(0.f, fabsf(fabsf(dif.y) - fabsf(d) * 2.f) * sign(dif.y));
-                    }
-                }
-                pts = {p1, p1a, p1b, p2};
-                ptCount = 4;
+                const ImVec2 normal = ImVec2(-dir.y, dir.x) * (ImMax(3.f * factor, 1.f) * 0.5f / length);
+                const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
+                drawList->PrimReserve(6, 4);
+                drawList->PrimQuadUV(p1 + normal, p2 + normal, p2 - normal, p1 - normal, uv, uv, uv, uv, col);
             }
+            continue;
         }
-        float highLightFactor = factor * (highlightCons ? 2.0f : 1.f);
-        for (int pass = 0; pass < 2; pass++)
+        LinkGeometry& geometry = linkGeometries[link_idx];
+        if (!geometry.IsValid(*link, *node_inp, *node_out, factor, col, highlightCons))
         {
-            drawList->AddPolyline(
-                pts.data(), ptCount, pass ? col : 0xFF000000, false, (pass ? 5.f : 7.5f) * highLightFactor);
+            BuildLinkGeometry(geometry, *link, *node_inp, *node_out, factor, col, highlightCons);
         }
+        geometry.Draw(drawList, offset);
     }
 }
 
@@ -320,35 +873,20 @@ static void HandleQuadSelection(
         drawList->AddRect(bmin, bmax, 0xFFFF2020, 1.f);
         if (!io.MouseDown[0])
         {
-            if (!io.KeyCtrl && !io.KeyShift)
+            // without shift, nodes outside the rectangle are unselected
+            if (!io.KeyShift)
             {
                 UnSelectNodes();
             }
 
             nodeOperation = NO_None;
-            ImRect selectionRect(bmin, bmax);
-            for (int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+            std::vector<uint32_t> quadNodes;
+            nodeGrid.Query(ImRect((bmin - offset) / factor, (bmax - offset) / factor), quadNodes);
+            for (auto nodeIndex : quadNodes)
             {
-                const auto* node = &nodes[nodeIndex];
-                ImVec2 node_rect_min = offset + node->mRect.Min * factor;
-                ImVec2 node_rect_max = node_rect_min + node->mRect.GetSize() * factor;
-                if (selectionRect.Overlaps(ImRect(node_rect_min, node_rect_max)))
+                if (nodeIndex < nodes.size())
                 {
-                    if (io.KeyCtrl)
-                    {
-                        SelectNode(nodeIndex, false);
-                    }
-                    else
-                    {
-                        SelectNode(nodeIndex, true);
-                    }
-                }
-                else
-                {
-                    if (!io.KeyShift)
-                    {
-                        SelectNode(nodeIndex, false);
-                    }
+                    SelectNode(nodeIndex, !io.KeyCtrl);
                 }
             }
         }
@@ -399,10 +937,13 @@ void HandleCopyCutPasteDelete(GraphEditorDelegate* delegate)
         delegate->CopyNodes(nodes);
         delegate->DeleteNodes(nodes);
         UnSelectNodes();
+        // remaining nodes are shifted
+        GraphEditorInvalidateSpatialIndex();
     }
     if (io.KeyCtrl && keyV)
     {
         auto pastedNodes = delegate->PasteNodes(ImVec2(40.f, 40.f));
+        UpdateSpatialIndex(delegate, pastedNodes);
         UnSelectNodes();
         for (auto nodeIndex : pastedNodes)
         {
@@ -414,6 +955,7 @@ void HandleCopyCutPasteDelete(GraphEditorDelegate* delegate)
         auto nodes = GetSelectedNodes();
         delegate->DeleteNodes(nodes);
         UnSelectNodes();
+        GraphEditorInvalidateSpatialIndex();
     }
 }
 
@@ -429,9 +971,6 @@ bool HandleConnections(ImDrawList* drawList,
     const auto& links = delegate->GetLinks();
     const auto& nodes = delegate->GetNodes();
 
-    
-    HandleCopyCutPasteDelete(delegate);
-    
     ImGuiIO& io = ImGui::GetIO();
     const GraphEditorDelegate::Node* node = &nodes[nodeIndex];
 
@@ -507,31 +1046,34 @@ bool HandleConnections(ImDrawList* drawList,
                     {
                         break;
                     }
+                    UpdateSpatialIndex(delegate);
                     bool alreadyExisting = false;
-                    for (int linkIndex = 0; linkIndex < links.size(); linkIndex++)
+                    const auto* sourceLinks = GetSlotLinks(inputSlotLinks, nl.mInputNodeIndex, nl.mInputSlotIndex);
+                    const auto* targetLinks = GetSlotLinks(outputSlotLinks, nl.mOutputNodeIndex, nl.mOutputSlotIndex);
+                    if (sourceLinks && targetLinks)
                     {
-                        if (!memcmp(&links[linkIndex], &nl, sizeof(GraphEditorDelegate::Link)))
+                        // an identical link is in both lists, the target one is usually a single link
+                        const auto* shortestLinks = (sourceLinks->size() < targetLinks->size()) ? sourceLinks : targetLinks;
+                        for (auto linkIndex : *shortestLinks)
                         {
-                            alreadyExisting = true;
-                            break;
+                            if (!memcmp(&links[linkIndex], &nl, sizeof(GraphEditorDelegate::Link)))
+                            {
+                                alreadyExisting = true;
+                                break;
+                            }
                         }
                     }
 
                     // check already connected output
-                    for (int linkIndex = 0; linkIndex < links.size(); linkIndex++)
+                    if (targetLinks)
                     {
-                        auto& link = links[linkIndex];
-                        if (link.mOutputNodeIndex == nl.mOutputNodeIndex && link.mOutputSlotIndex == nl.mOutputSlotIndex)
+                        if (!inTransaction)
                         {
-                            if (!inTransaction)
-                            {
-                                delegate->BeginTransaction(true);
-                                inTransaction = true;
-                            }
-                            delegate->DelLink(linkIndex);
-                            
-                            break;
+                            delegate->BeginTransaction(true);
+                            inTransaction = true;
                         }
+                        delegate->DelLink(targetLinks->front());
+                        UpdateLinkIndex(delegate);
                     }
 
                     if (!alreadyExisting)
@@ -542,6 +1084,7 @@ bool HandleConnections(ImDrawList* drawList,
                             inTransaction = true;
                         }
                         delegate->AddLink(nl.mInputNodeIndex, nl.mInputSlotIndex, nl.mOutputNodeIndex, nl.mOutputSlotIndex);
+                        UpdateLinkIndex(delegate);
                     }
                 }
             }
@@ -558,19 +1101,17 @@ bool HandleConnections(ImDrawList* drawList,
                 if (editingInput)
                 {
                     // remove existing link
-                    for (int linkIndex = 0; linkIndex < links.size(); linkIndex++)
+                    UpdateSpatialIndex(delegate);
+                    const auto* targetLinks = GetSlotLinks(outputSlotLinks, nodeIndex, closestConn);
+                    if (targetLinks)
                     {
-                        auto& link = links[linkIndex];
-                        if (link.mOutputNodeIndex == nodeIndex && link.mOutputSlotIndex == closestConn)
+                        if (!inTransaction)
                         {
-                            if (!inTransaction)
-                            {
-                                delegate->BeginTransaction(true);
-                                inTransaction = true;
-                            }
-                            delegate->DelLink(linkIndex);
-                            break;
+                            delegate->BeginTransaction(true);
+                            inTransaction = true;
                         }
+                        delegate->DelLink(targetLinks->front());
+                        UpdateLinkIndex(delegate);
                     }
                 }
             }
@@ -594,6 +1135,71 @@ static void DrawGrid(ImDrawList* drawList, ImVec2 windowPos, const ImVec2 canvas
         drawList->AddLine(ImVec2(0.0f, y) + windowPos, ImVec2(canvasSize.x, y) + windowPos, GRID_COLOR);
 }
 
+// Zoomed out nodes: one quad each, in a single reservation. Nodes near the mouse are left in
+// nodeIndices for the detailed path, the others are removed.
+static void DrawNodesLOD(ImDrawList* drawList,
+                         std::vector<uint32_t>& nodeIndices,
+                         const ImVec2 offset,
+                         const float factor,
+                         GraphEditorDelegate* delegate,
+                         const ImRect regionRect)
+{
+    ImGuiIO& io = ImGui::GetIO();
+    const auto& nodes = delegate->GetNodes();
+    const ImVec2 uv = drawList->_Data->TexUvWhitePixel;
+    size_t detailedCount = 0;
+    static std::vector<uint32_t> quadNodes;
+    quadNodes.clear();
+    for (auto nodeIndex : nodeIndices)
+    {
+        ImRect nodeRect = GetNodeRect(nodes[nodeIndex], factor);
+        if (IsNodeSelected(nodeIndex))
+        {
+            nodeRect.Min += movingNodesOffset * factor;
+            nodeRect.Max += movingNodesOffset * factor;
+        }
+        nodeRect.Min += offset;
+        nodeRect.Max += offset;
+        ImRect nearRect = nodeRect;
+        nearRect.Expand(NODE_SLOT_RADIUS * 2.f);
+        if (nearRect.Contains(io.MousePos))
+        {
+            nodeIndices[detailedCount++] = nodeIndex;
+        }
+        else if (regionRect.Overlaps(nodeRect))
+        {
+            quadNodes.push_back(nodeIndex);
+        }
+    }
+    nodeIndices.resize(detailedCount);
+    if (quadNodes.empty())
+    {
+        return;
+    }
+
+    // reserved by chunks so a reservation's vertices stay addressable with 16-bit indices
+    const size_t maxQuadsPerReserve = 65535 / 4;
+    for (size_t quad = 0; quad < quadNodes.size(); quad++)
+    {
+        if (!(quad % maxQuadsPerReserve))
+        {
+            const int quadCount = int(ImMin(quadNodes.size() - quad, maxQuadsPerReserve));
+            drawList->PrimReserve(quadCount * 6, quadCount * 4);
+        }
+        const uint32_t nodeIndex = quadNodes[quad];
+        const auto& node = nodes[nodeIndex];
+        ImRect nodeRect = GetNodeRect(node, factor);
+        const bool selected = IsNodeSelected(nodeIndex);
+        if (selected)
+        {
+            nodeRect.Min += movingNodesOffset * factor;
+            nodeRect.Max += movingNodesOffset * factor;
+        }
+        const ImU32 color = selected ? IM_COL32(255, 130, 30, 255) : node.mHeaderColor;
+        drawList->PrimRectUV(offset + nodeRect.Min, offset + nodeRect.Max, uv, uv, color);
+    }
+}
+
 // return true if node is hovered
 static bool DrawNode(ImDrawList* drawList,
                      int nodeIndex,
@@ -607,8 +1213,7 @@ static bool DrawNode(ImDrawList* drawList,
     const auto* node = &nodes[nodeIndex];
 
     ImRect nodeRect = node->mRect;
-    auto iter = std::find(selectedNodes.begin(), selectedNodes.end(), nodeIndex);
-    if (iter != selectedNodes.end())
+    if (IsNodeSelected(nodeIndex))
     {
         nodeRect.Min += movingNodesOffset;
         nodeRect.Max += movingNodesOffset;
@@ -670,10 +1275,7 @@ static bool DrawNode(ImDrawList* drawList,
             {
                 if (!io.KeyShift)
                 {
-                    for (auto i = 0; i < nodes.size(); i++)
-                    {
-                        SelectNode(i, false);
-                    }
+                    UnSelectNodes();
                 }
                 SelectNode(nodeIndex, true);
             }
@@ -845,16 +1447,20 @@ void GraphEditor(GraphEditorDelegate* delegate, bool enabled)
         DrawGrid(drawList, windowPos, canvasSize, factor);
     }
 
+    const bool lod = factor < LOD_FACTOR;
     if (!enabled)
     {
         goto nodeGraphExit;
     }
 
+    HandleCopyCutPasteDelete(delegate);
+    UpdateSpatialIndex(delegate);
+
     static int hoveredNode = -1;
     // Display links
     drawList->ChannelsSplit(3);
     drawList->ChannelsSetCurrent(1); // Background
-    DisplayLinks(delegate, drawList, offset, factor, regionRect, hoveredNode);
+    DisplayLinks(delegate, drawList, offset, factor, regionRect, hoveredNode, lod);
 
     // edit node link
     if (nodeOperation == NO_EditingLink)
@@ -867,9 +1473,16 @@ void GraphEditor(GraphEditorDelegate* delegate, bool enabled)
     // Display nodes
     drawList->PushClipRect(regionRect.Min, regionRect.Max, true);
     hoveredNode = -1;
+    static std::vector<uint32_t> visibleNodes;
+    visibleNodes.clear();
+    nodeGrid.Query(ImRect((regionRect.Min - offset) / factor, (regionRect.Max - offset) / factor), visibleNodes);
+    if (lod)
+    {
+        DrawNodesLOD(drawList, visibleNodes, offset, factor, delegate, regionRect);
+    }
     for (int i = 0; i < 1; i++)
     {
-        for (int nodeIndex = 0; nodeIndex < nodes.size(); nodeIndex++)
+        for (auto nodeIndex : visibleNodes)
         {
             const auto* node = &nodes[nodeIndex];
             /*if (node->mbSelected != (i != 0))
@@ -933,6 +1546,7 @@ void GraphEditor(GraphEditorDelegate* delegate, bool enabled)
         {
             std::vector<NodeIndex> movedNodes = GetSelectedNodes();
             delegate->MoveNodes(movedNodes, movingNodesOffset);
+            UpdateSpatialIndex(delegate, movedNodes);
             movingNodesOffset = ImVec2(0.f, 0.f);
         }
     }
@@ -25,6 +25,7 @@
 #pragma once
 
 #include <vector>
+#include <algorithm>
 #include <stdint.h>
 #include <string>
 #include "imgui.h"
@@ -33,6 +34,49 @@
 typedef unsigned int NodeIndex;
 typedef unsigned int SlotIndex;
 
+// Ordered record of the changes made to a delegate nodes and links, so caches can update
+// incrementally. Indices are the positions at the time of the change: removals shift the
+// following nodes or links, additions are appended (use Reset for anything else).
+// Only the last changes are kept.
+struct GraphChangeJournal
+{
+    enum ChangeType : uint8_t
+    {
+        NodeAdded,
+        NodeRemoved,
+        NodeMoved,
+        LinkAdded,
+        LinkRemoved,
+    };
+
+    struct Change
+    {
+        ChangeType mType;
+        uint32_t mIndex;
+    };
+
+    void Record(ChangeType type, uint32_t index);
+    // Everything changed, consumers resynchronize
+    void Reset();
+
+    // Incremented by each change
+    uint64_t GetGeneration() const { return mGeneration; }
+    uint64_t GetNodeGeneration() const { return mNodeGeneration; }
+    uint64_t GetLinkGeneration() const { return mLinkGeneration; }
+
+    // Appends the changes made since generation. Returns false when they are no longer available.
+    bool GetChanges(uint64_t generation, std::vector<Change>& changes) const;
+
+private:
+    static const size_t Capacity = 4096;
+
+    std::vector<Change> mChanges; // ring, the change of generation g is at g % Capacity
+    uint64_t mGeneration{ 0 };
+    uint64_t mResetGeneration{ 0 };
+    uint64_t mNodeGeneration{ 0 };
+    uint64_t mLinkGeneration{ 0 };
+};
+
 struct GraphEditorDelegate
 {
     // getters
@@ -70,13 +114,37 @@ struct GraphEditorDelegate
         int mInputNodeIndex, mInputSlotIndex, mOutputNodeIndex, mOutputSlotIndex;
     };
 
+    // batch link edits, override when the links can be changed in one pass.
+    // linkIndices are the indices before the call.
+    virtual void AddLinks(const std::vector<Link>& links)
+    {
+        for (const auto& link : links)
+        {
+            AddLink(link.mInputNodeIndex, link.mInputSlotIndex, link.mOutputNodeIndex, link.mOutputSlotIndex);
+        }
+    }
+    virtual void DelLinks(std::vector<size_t> linkIndices)
+    {
+        std::sort(linkIndices.begin(), linkIndices.end());
+        linkIndices.erase(std::unique(linkIndices.begin(), linkIndices.end()), linkIndices.end());
+        for (auto iter = linkIndices.rbegin(); iter != linkIndices.rend(); ++iter)
+        {
+            DelLink(*iter);
+        }
+    }
+
     // node/links/rugs retrieval
     virtual const std::vector<Node>& GetNodes() const = 0;
     virtual const std::vector<Link>& GetLinks() const = 0;
+
+    // optional, without a journal the editor only notices node and link count changes
+    virtual const GraphChangeJournal* GetChangeJournal() const { return nullptr; }
 };
 
 void GraphEditor(GraphEditorDelegate* delegate, bool enabled);
 void GraphEditorClear();
+// Call when nodes or links were changed outside of the editor operations
+void GraphEditorInvalidateSpatialIndex();
 
 void GraphEditorUpdateScrolling(GraphEditorDelegate* delegate);
 
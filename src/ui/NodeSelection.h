@@ -0,0 +1,90 @@
+// https://github.com/CedricGuillemet/Imogen
+//
+// The MIT License(MIT)
+//
+// Copyright(c) 2019 Cedric Guillemet
+//
+// Permission is hereby granted, free of charge, to any person obtaining a copy
+// of this software and associated documentation files(the "Software"), to deal
+// in the Software without restriction, including without limitation the rights
+// to use, copy, modify, merge, publish, distribute, sublicense, and / or sell
+// copies of the Software, and to permit persons to whom the Software is
+// furnished to do so, subject to the following conditions :
+//
+// The above copyright notice and this permission notice shall be included in all
+// copies or substantial portions of the Software.
+//
+// THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+// IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+// FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT.IN NO EVENT SHALL THE
+// AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+// LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+// OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+// SOFTWARE.
+//
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+#include <vector>
+
+// Selected nodes: a bit per node for the tests and the list of selected indices for iteration.
+// Select, unselect and test are O(1), clearing and iterating are O(selected).
+struct NodeSelection
+{
+    bool IsSelected(uint32_t nodeIndex) const
+    {
+        const size_t word = nodeIndex >> 6;
+        return word < mBits.size() && (mBits[word] & (1ULL << (nodeIndex & 63)));
+    }
+
+    void Select(uint32_t nodeIndex, bool selected)
+    {
+        if (IsSelected(nodeIndex) == selected)
+        {
+            return;
+        }
+        const size_t word = nodeIndex >> 6;
+        if (selected)
+        {
+            if (word >= mBits.size())
+            {
+                mBits.resize(word + 1, 0);
+                mListPositions.resize(mBits.size() * 64);
+            }
+            mBits[word] |= 1ULL << (nodeIndex & 63);
+            mListPositions[nodeIndex] = uint32_t(mNodes.size());
+            mNodes.push_back(nodeIndex);
+        }
+        else
+        {
+            mBits[word] &= ~(1ULL << (nodeIndex & 63));
+            const uint32_t position = mListPositions[nodeIndex];
+            const uint32_t last = mNodes.back();
+            mNodes[position] = last;
+            mListPositions[last] = position;
+            mNodes.pop_back();
+        }
+    }
+
+    void Clear()
+    {
+        for (auto nodeIndex : mNodes)
+        {
+            mBits[nodeIndex >> 6] = 0;
+        }
+        mNodes.clear();
+    }
+
+    // unordered
+    const std::vector<uint32_t>& GetNodes() const
+    {
+        return mNodes;
+    }
+
+private:
+    std::vector<uint64_t> mBits;
+    std::vector<uint32_t> mNodes;
+    std::vector<uint32_t> mListPositions; // of each selected node in mNodes
+};
@@ -11,16 +11,70 @@ void UIInit()
     InitFonts();
 }
 
+// Stable node reference: stays valid while the node exists, whatever the edits on other nodes
+struct NodeHandle
+{
+    uint32_t mSlot;
+    uint32_t mGeneration;
+
+    bool operator==(const NodeHandle& other) const { return mSlot == other.mSlot && mGeneration == other.mGeneration; }
+    bool operator!=(const NodeHandle& other) const { return !(*this == other); }
+};
+
+static const NodeHandle InvalidNodeHandle = { 0xFFFFFFFF, 0 };
+
 struct GEDelegate : public GraphEditorDelegate
 {
     //NodeIndex mSelectedNodeIndex{ InvalidNodeIndex };
     GEDelegate()
     {
-        mNodes.push_back({"My Node", ImRect(ImVec2(0.f,0.f), ImVec2(200.f, 200.f)), 0xFFAAAAAA, 0xFF555555});
-        mNodes.push_back({ "My Node", ImRect(ImVec2(300.f,0.f), ImVec2(300 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
-        mNodes.push_back({ "My Node", ImRect(ImVec2(600.f,0.f), ImVec2(600 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
-        mNodes.push_back({ "My Node", ImRect(ImVec2(900.f,0.f), ImVec2(900 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
-        mNodes.push_back({ "My Node", ImRect(ImVec2(1200.f,0.f), ImVec2(1200 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
+        AddNode({"My Node", ImRect(ImVec2(0.f,0.f), ImVec2(200.f, 200.f)), 0xFFAAAAAA, 0xFF555555});
+        AddNode({ "My Node", ImRect(ImVec2(300.f,0.f), ImVec2(300 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
+        AddNode({ "My Node", ImRect(ImVec2(600.f,0.f), ImVec2(600 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
+        AddNode({ "My Node", ImRect(ImVec2(900.f,0.f), ImVec2(900 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
+        AddNode({ "My Node", ImRect(ImVec2(1200.f,0.f), ImVec2(1200 + 200.f, 200.f)), 0xFFAAAAAA, 0xFF555555 });
+    }
+
+    // Nodes are stored densely in mNodes for the editor. A slot per handle holds the node position
+    // and the generation, bumped when the node is deleted so older handles are detected.
+    NodeHandle AddNode(const GraphEditorDelegate::Node& node)
+    {
+        uint32_t slot;
+        if (!mFreeSlots.empty())
+        {
+            slot = mFreeSlots.back();
+            mFreeSlots.pop_back();
+        }
+        else
+        {
+            slot = uint32_t(mSlots.size());
+            mSlots.push_back({ 0, 0 });
+        }
+        mSlots[slot].mNodeIndex = NodeIndex(mNodes.size());
+        mNodes.push_back(node);
+        mNodeSlots.push_back(slot);
+        return { slot, mSlots[slot].mGeneration };
+    }
+
+    NodeHandle GetNodeHandle(NodeIndex nodeIndex) const
+    {
+        if (nodeIndex >= mNodes.size())
+        {
+            return InvalidNodeHandle;
+        }
+        const uint32_t slot = mNodeSlots[nodeIndex];
+        return { slot, mSlots[slot].mGeneration };
+    }
+
+    bool IsValid(NodeHandle handle) const
+    {
+        return handle.mSlot < mSlots.size() && mSlots[handle.mSlot].mGeneration == handle.mGeneration;
+    }
+
+    // current position in GetNodes()
+    NodeIndex GetNodeIndex(NodeHandle handle) const
+    {
+        return mSlots[handle.mSlot].mNodeIndex;
     }
     // getters
     virtual ImVec2 GetEvaluationSize(NodeIndex nodeIndex) const { return ImVec2(150, 150); }
@@ -40,6 +94,7 @@ struct GEDelegate : public GraphEditorDelegate
         {
             mNodes[nodeIndex].mRect.Min += delta;
             mNodes[nodeIndex].mRect.Max += delta;
+            mJournal.Record(GraphChangeJournal::NodeMoved, nodeIndex);
         }
     }
     
@@ -53,31 +108,129 @@ struct GEDelegate : public GraphEditorDelegate
     
     virtual void DeleteNodes(std::vector<NodeIndex>& nodes)
     {
+        if (nodes.empty())
+        {
+            return;
+        }
+        // the last node takes the place of each deleted one. Going from the highest index, the
+        // last node is never one still to delete.
         std::vector<NodeIndex> sortedIndices = nodes;
         std::sort(sortedIndices.begin(), sortedIndices.end());
-        std::reverse(sortedIndices.begin(), sortedIndices.end());
-        for (auto nodeIndex : sortedIndices)
+        sortedIndices.erase(std::unique(sortedIndices.begin(), sortedIndices.end()), sortedIndices.end());
+        for (auto iter = sortedIndices.rbegin(); iter != sortedIndices.rend(); ++iter)
+        {
+            const NodeIndex nodeIndex = *iter;
+            if (nodeIndex >= mNodes.size())
+            {
+                continue;
+            }
+            const uint32_t slot = mNodeSlots[nodeIndex];
+            mSlots[slot].mGeneration++;
+            mFreeSlots.push_back(slot);
+
+            const NodeIndex lastIndex = NodeIndex(mNodes.size() - 1);
+            if (nodeIndex != lastIndex)
+            {
+                mNodes[nodeIndex] = std::move(mNodes[lastIndex]);
+                mNodeSlots[nodeIndex] = mNodeSlots[lastIndex];
+                mSlots[mNodeSlots[nodeIndex]].mNodeIndex = nodeIndex;
+            }
+            mNodes.pop_back();
+            mNodeSlots.pop_back();
+        }
+
+        // one pass over the links: drop the ones to deleted nodes, remap the others
+        size_t linkCount = 0;
+        for (size_t linkIndex = 0; linkIndex < mLinkHandles.size(); linkIndex++)
         {
-            mNodes.erase(mNodes.begin() + nodeIndex);
+            const LinkHandles& handles = mLinkHandles[linkIndex];
+            if (!IsValid(handles.mInputNode) || !IsValid(handles.mOutputNode))
+            {
+                continue;
+            }
+            Link& link = mLinks[linkCount];
+            link = mLinks[linkIndex];
+            link.mInputNodeIndex = int(GetNodeIndex(handles.mInputNode));
+            link.mOutputNodeIndex = int(GetNodeIndex(handles.mOutputNode));
+            mLinkHandles[linkCount++] = handles;
         }
+        mLinks.resize(linkCount);
+        mLinkHandles.resize(linkCount);
+
+        // nodes are reordered: consumers resynchronize
+        mJournal.Reset();
     }
 
     virtual std::vector<NodeIndex> PasteNodes(const ImVec2 offset)
     {
         std::vector<NodeIndex> pastedNodeIndex;
+        pastedNodeIndex.reserve(mClipboard.size());
+        mNodes.reserve(mNodes.size() + mClipboard.size());
         for (auto& node : mClipboard)
         {
             pastedNodeIndex.push_back(NodeIndex(mNodes.size()));
-            mNodes.push_back(node);
+            AddNode(node);
             mNodes.back().mRect.Min += offset;
             mNodes.back().mRect.Max += offset;
+            mJournal.Record(GraphChangeJournal::NodeAdded, pastedNodeIndex.back());
         }
         return pastedNodeIndex;
     }
 
 
-    virtual void AddLink(NodeIndex inputNodeIndex, SlotIndex inputSlotIndex, NodeIndex outputNodeIndex, SlotIndex outputSlotIndex) {}
-    virtual void DelLink(size_t linkIndex) {}
+    virtual void AddLink(NodeIndex inputNodeIndex, SlotIndex inputSlotIndex, NodeIndex outputNodeIndex, SlotIndex outputSlotIndex)
+    {
+        mLinks.push_back({ int(inputNodeIndex), int(inputSlotIndex), int(outputNodeIndex), int(outputSlotIndex) });
+        mLinkHandles.push_back({ GetNodeHandle(inputNodeIndex), GetNodeHandle(outputNodeIndex) });
+        mJournal.Record(GraphChangeJournal::LinkAdded, uint32_t(mLinks.size() - 1));
+    }
+
+    virtual void DelLink(size_t linkIndex)
+    {
+        mLinks.erase(mLinks.begin() + linkIndex);
+        mLinkHandles.erase(mLinkHandles.begin() + linkIndex);
+        mJournal.Record(GraphChangeJournal::LinkRemoved, uint32_t(linkIndex));
+    }
+
+    virtual void AddLinks(const std::vector<Link>& links)
+    {
+        mLinks.reserve(mLinks.size() + links.size());
+        mLinkHandles.reserve(mLinkHandles.size() + links.size());
+        for (const auto& link : links)
+        {
+            AddLink(link.mInputNodeIndex, link.mInputSlotIndex, link.mOutputNodeIndex, link.mOutputSlotIndex);
+        }
+    }
+
+    virtual void DelLinks(std::vector<size_t> linkIndices)
+    {
+        std::sort(linkIndices.begin(), linkIndices.end());
+        linkIndices.erase(std::unique(linkIndices.begin(), linkIndices.end()), linkIndices.end());
+        if (linkIndices.empty())
+        {
+            return;
+        }
+        // one compaction pass. Removals are journaled from the last one so each index is the
+        // position at the time of the change.
+        size_t linkCount = 0;
+        size_t deleted = 0;
+        for (size_t linkIndex = 0; linkIndex < mLinks.size(); linkIndex++)
+        {
+            if (deleted < linkIndices.size() && linkIndices[deleted] == linkIndex)
+            {
+                deleted++;
+                continue;
+            }
+            mLinks[linkCount] = mLinks[linkIndex];
+            mLinkHandles[linkCount++] = mLinkHandles[linkIndex];
+        }
+        mLinks.resize(linkCount);
+        mLinkHandles.resize(linkCount);
+        for (size_t index = deleted; index--;)
+        {
+            mJournal.Record(GraphChangeJournal::LinkRemoved, uint32_t(linkIndices[index]));
+        }
+    }
 
     virtual const std::vector<GraphEditorDelegate::Node>& GetNodes() const
     {
@@ -89,10 +242,33 @@ struct GEDelegate : public GraphEditorDelegate
         return mLinks;
     }
 
+    virtual const GraphChangeJournal* GetChangeJournal() const
+    {
+        return &mJournal;
+    }
+
+    struct NodeSlot
+    {
+        NodeIndex mNodeIndex;
+        uint32_t mGeneration;
+    };
+
+    // link ends by handle, mLinks is their positional view for the editor
+    struct LinkHandles
+    {
+        NodeHandle mInputNode;
+        NodeHandle mOutputNode;
+    };
+
     std::vector<GraphEditorDelegate::Node> mNodes;
+    std::vector<uint32_t> mNodeSlots; // slot of each node
+    std::vector<NodeSlot> mSlots;
+    std::vector<uint32_t> mFreeSlots;
     std::vector<GraphEditorDelegate::Link> mLinks;
+    std::vector<LinkHandles> mLinkHandles;
 
     std::vector<GraphEditorDelegate::Node> mClipboard;
+    GraphChangeJournal mJournal;
 };
 void ShowNodeGraph()
 {